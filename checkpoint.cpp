@@ -0,0 +1,264 @@
+#include "checkpoint.hpp"
+#include <stdexcept>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const char CHECKPOINT_MAGIC[8] = {'N', 'N', 'C', 'K', 'P', 'T', '0', '1'};
+
+// --- Serialization Helpers ---
+
+template <typename T>
+static void appendValue(std::vector<char>& out, const T& value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+static void appendMatrix(std::vector<char>& out, const Matrix& m) {
+    appendValue<int>(out, m.getRows());
+    appendValue<int>(out, m.getCols());
+    for (int i = 0; i < m.getRows(); ++i) {
+        for (int j = 0; j < m.getCols(); ++j) {
+            appendValue<double>(out, m(i, j));
+        }
+    }
+}
+
+template <typename T>
+static T readValue(std::istream& in) {
+    T value;
+    if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+        throw std::runtime_error("Checkpoint file is truncated.");
+    }
+    return value;
+}
+
+static void readMatrixInto(std::istream& in, Matrix& m) {
+    int rows = readValue<int>(in);
+    int cols = readValue<int>(in);
+    if (rows != m.getRows() || cols != m.getCols()) {
+        throw std::runtime_error("Checkpoint matrix dimensions do not match the network.");
+    }
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            m(i, j) = readValue<double>(in);
+        }
+    }
+}
+
+static void writeAll(int fd, const char* bytes, size_t size, const std::string& file) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, bytes, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Failed to write checkpoint " + file + ": " + std::strerror(errno));
+        }
+        bytes += n;
+        size -= n;
+    }
+}
+
+// --- Constructor / Destructor ---
+
+Checkpointer::Checkpointer(const std::string& path)
+    : path(path), has_pending(false), busy(false), stopping(false), written_count(0) {
+    writer = std::thread(&Checkpointer::writerLoop, this);
+}
+
+Checkpointer::~Checkpointer() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    work_cv.notify_one();
+    writer.join();
+
+    // Destructors can't throw, but a lost final checkpoint must not go unnoticed
+    if (!write_error.empty()) {
+        std::cerr << "Warning: " << write_error << std::endl;
+    }
+}
+
+// --- Training Thread Side ---
+
+void Checkpointer::capture(const NeuralNetwork& nn, int epoch) {
+    std::lock_guard<std::mutex> lock(mtx);
+    // Copy-assigning into the existing matrices reuses their storage, so after
+    // the first capture this is just a memcpy of the parameters.
+    pending.epoch = epoch;
+    pending.training_rate = nn.training_rate;
+    pending.momentum = nn.momentum;
+    pending.layer_nodes = nn.layer_nodes;
+    pending.layer_activations = nn.layer_activations;
+    pending.weights = nn.weights;
+    pending.biases = nn.biases;
+    pending.weight_velocities = nn.weight_velocities;
+    pending.bias_velocities = nn.bias_velocities;
+    has_pending = true;
+    work_cv.notify_one();
+}
+
+void Checkpointer::flush() {
+    std::unique_lock<std::mutex> lock(mtx);
+    idle_cv.wait(lock, [this] { return !has_pending && !busy; });
+    if (!write_error.empty()) {
+        std::string error = write_error;
+        write_error.clear();
+        throw std::runtime_error(error);
+    }
+}
+
+int Checkpointer::writtenCount() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return written_count;
+}
+
+// --- Writer Thread Side ---
+
+void Checkpointer::writerLoop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        work_cv.wait(lock, [this] { return has_pending || stopping; });
+        if (!has_pending) {
+            break; // stopping, and nothing left to write
+        }
+        std::swap(pending, writing);
+        has_pending = false;
+        busy = true;
+
+        lock.unlock();
+        std::string error;
+        try {
+            writeSnapshot(writing);
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        lock.lock();
+
+        busy = false;
+        if (error.empty()) {
+            ++written_count;
+        } else {
+            write_error = error;
+        }
+        idle_cv.notify_all();
+    }
+}
+
+void Checkpointer::writeSnapshot(const Snapshot& snapshot) const {
+    std::vector<char> buffer;
+    buffer.insert(buffer.end(), CHECKPOINT_MAGIC, CHECKPOINT_MAGIC + sizeof(CHECKPOINT_MAGIC));
+    appendValue<int>(buffer, snapshot.epoch);
+    appendValue<double>(buffer, snapshot.training_rate);
+    appendValue<double>(buffer, snapshot.momentum);
+
+    appendValue<int>(buffer, snapshot.layer_nodes.size());
+    for (int i = 0; i < snapshot.layer_nodes.size(); ++i) {
+        const std::string& activation = snapshot.layer_activations[i];
+        appendValue<int>(buffer, snapshot.layer_nodes[i]);
+        appendValue<int>(buffer, activation.size());
+        buffer.insert(buffer.end(), activation.begin(), activation.end());
+    }
+
+    appendValue<int>(buffer, snapshot.weights.size());
+    for (const Matrix& m : snapshot.weights) appendMatrix(buffer, m);
+    for (const Matrix& m : snapshot.biases) appendMatrix(buffer, m);
+    for (const Matrix& m : snapshot.weight_velocities) appendMatrix(buffer, m);
+    for (const Matrix& m : snapshot.bias_velocities) appendMatrix(buffer, m);
+
+    std::string tmp_path = path + ".tmp";
+    int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open checkpoint " + tmp_path + ": " + std::strerror(errno));
+    }
+    try {
+        writeAll(fd, buffer.data(), buffer.size(), tmp_path);
+        if (::fsync(fd) != 0) {
+            throw std::runtime_error("Failed to fsync checkpoint " + tmp_path + ": " + std::strerror(errno));
+        }
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+
+    if (::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Failed to rename checkpoint to " + path + ": " + std::strerror(errno));
+    }
+
+    // fsync the directory too, otherwise the rename itself may not survive a crash
+    std::string::size_type slash = path.find_last_of('/');
+    std::string dir = (slash == std::string::npos) ? "." : path.substr(0, slash + 1);
+    int dir_fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+}
+
+// --- Resume ---
+
+int Checkpointer::resume(const std::string& path, NeuralNetwork& nn) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        if (errno == ENOENT) {
+            return -1; // nothing saved yet, start from scratch
+        }
+        // Any other failure would silently restart training from epoch 0
+        throw std::runtime_error("Failed to open checkpoint " + path + ": " + std::strerror(errno));
+    }
+
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0) {
+        throw std::runtime_error("Not a checkpoint file: " + path);
+    }
+
+    int epoch = readValue<int>(in);
+    double training_rate = readValue<double>(in);
+    double momentum = readValue<double>(in);
+
+    int layer_count = readValue<int>(in);
+    if (layer_count != nn.layer_nodes.size()) {
+        throw std::runtime_error("Checkpoint layer count does not match the network.");
+    }
+    for (int i = 0; i < layer_count; ++i) {
+        int nodes = readValue<int>(in);
+        int name_length = readValue<int>(in);
+        std::string activation(name_length, '\0');
+        if (name_length > 0 && !in.read(&activation[0], name_length)) {
+            throw std::runtime_error("Checkpoint file is truncated.");
+        }
+        if (nodes != nn.layer_nodes[i] || activation != nn.layer_activations[i]) {
+            throw std::runtime_error("Checkpoint layer " + std::to_string(i) + " does not match the network.");
+        }
+    }
+
+    int matrix_count = readValue<int>(in);
+    if (matrix_count != nn.weights.size()) {
+        throw std::runtime_error("Checkpoint weight count does not match the network.");
+    }
+
+    // Read into copies first so a bad file leaves the network untouched
+    std::vector<Matrix> weights = nn.weights;
+    std::vector<Matrix> biases = nn.biases;
+    std::vector<Matrix> weight_velocities = nn.weight_velocities;
+    std::vector<Matrix> bias_velocities = nn.bias_velocities;
+    for (Matrix& m : weights) readMatrixInto(in, m);
+    for (Matrix& m : biases) readMatrixInto(in, m);
+    for (Matrix& m : weight_velocities) readMatrixInto(in, m);
+    for (Matrix& m : bias_velocities) readMatrixInto(in, m);
+
+    nn.training_rate = training_rate;
+    nn.momentum = momentum;
+    nn.weights = weights;
+    nn.biases = biases;
+    nn.weight_velocities = weight_velocities;
+    nn.bias_velocities = bias_velocities;
+    nn.dropSparseWeights();
+    return epoch;
+}
@@ -0,0 +1,106 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "matrix.hpp"
+#include "neuralNetwork.hpp"
+
+/**
+ * @brief Writes training checkpoints from a background thread.
+ *
+ * capture() only copies the parameters into a staging buffer, so the
+ * training loop never waits on the disk. The writer thread then saves the
+ * staged copy to "<path>.tmp", fsyncs it and renames it over <path>, so a
+ * crash mid-write always leaves the previous checkpoint intact.
+ */
+class Checkpointer {
+private:
+    /**
+     * @brief Everything needed to resume training: topology, parameters
+     * and optimizer state.
+     */
+    struct Snapshot {
+        int epoch = -1;
+        double training_rate = 0.0;
+        double momentum = 0.0;
+        std::vector<int> layer_nodes;
+        std::vector<std::string> layer_activations;
+        std::vector<Matrix> weights;
+        std::vector<Matrix> biases;
+        std::vector<Matrix> weight_velocities;
+        std::vector<Matrix> bias_velocities;
+    };
+
+    std::string path;
+
+    /**
+     * @brief pending is filled by capture(); the writer swaps it with
+     * writing before going to disk, so capture() never waits on a write.
+     */
+    Snapshot pending;
+    Snapshot writing;
+    bool has_pending;
+    bool busy;
+    bool stopping;
+    std::string write_error;
+    int written_count;
+
+    std::mutex mtx;
+    std::condition_variable work_cv;
+    std::condition_variable idle_cv;
+    std::thread writer;
+
+    void writerLoop();
+    void writeSnapshot(const Snapshot& snapshot) const;
+
+public:
+    /**
+     * @brief Starts the writer thread.
+     * @param path Final checkpoint file; "<path>.tmp" is used while writing.
+     */
+    explicit Checkpointer(const std::string& path);
+
+    /**
+     * @brief Writes any pending checkpoint and stops the writer thread.
+     * A write error nobody collected through flush() is printed to std::cerr.
+     */
+    ~Checkpointer();
+
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    /**
+     * @brief Copies the network's parameters and velocities into the staging
+     * buffer and returns. Call it at an epoch boundary. If the previous
+     * capture hasn't been written yet, it is replaced by this one.
+     * @param nn The network to save.
+     * @param epoch The last completed epoch, returned by resume().
+     */
+    void capture(const NeuralNetwork& nn, int epoch);
+
+    /**
+     * @brief Blocks until every captured checkpoint is on disk.
+     * Throws std::runtime_error if a write failed.
+     */
+    void flush();
+
+    /**
+     * @brief Number of checkpoints written so far.
+     */
+    int writtenCount();
+
+    /**
+     * @brief Loads a checkpoint into a network built with the same layers.
+     * @param path The checkpoint file.
+     * @param nn The network to restore into; its topology must match.
+     * @return The epoch stored in the checkpoint, or -1 if the file doesn't exist.
+     * Throws std::runtime_error if it exists but can't be read.
+     */
+    static int resume(const std::string& path, NeuralNetwork& nn);
+};
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,142 @@
+#include "conv2d.hpp"
+#include <stdexcept>
+#include <limits>
+
+// A column vector is contiguous in either layout (row-major has leading
+// dimension 1, column-major stores it as a single line), so line(0) walks it.
+static const double* columnData(const Matrix& v, int expected_size) {
+    if (v.getRows() != expected_size || v.getCols() != 1) {
+        throw std::invalid_argument("Image does not match the layer's input shape.");
+    }
+    return v.line(0);
+}
+
+int Conv2D::outputSize(int input_size, const WindowParams& window) {
+    if (window.kernel <= 0 || window.stride <= 0 || window.padding < 0) {
+        throw std::invalid_argument("Window kernel and stride must be positive.");
+    }
+    int span = input_size + 2 * window.padding - window.kernel;
+    if (span < 0) {
+        throw std::invalid_argument("Window is larger than the padded input.");
+    }
+    return span / window.stride + 1;
+}
+
+TensorShape Conv2D::outputShape(const TensorShape& in, int channels, const WindowParams& window) {
+    return {channels, outputSize(in.height, window), outputSize(in.width, window)};
+}
+
+Matrix Conv2D::im2col(const Matrix& input, const TensorShape& in, const WindowParams& window) {
+    const double* image = columnData(input, in.size());
+    const int k = window.kernel;
+    const int out_h = outputSize(in.height, window);
+    const int out_w = outputSize(in.width, window);
+
+    Matrix cols(in.channels * k * k, out_h * out_w);
+    for (int c = 0; c < in.channels; ++c) {
+        const double* plane = image + c * in.height * in.width;
+        for (int ky = 0; ky < k; ++ky) {
+            for (int kx = 0; kx < k; ++kx) {
+                double* out = cols.line((c * k + ky) * k + kx);
+                for (int oy = 0; oy < out_h; ++oy) {
+                    int y = oy * window.stride - window.padding + ky;
+                    if (y < 0 || y >= in.height) {
+                        continue; // whole output row reads padding, already zero
+                    }
+                    for (int ox = 0; ox < out_w; ++ox) {
+                        int x = ox * window.stride - window.padding + kx;
+                        if (x >= 0 && x < in.width) {
+                            out[oy * out_w + ox] = plane[y * in.width + x];
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return cols;
+}
+
+Matrix Conv2D::col2im(const Matrix& cols, const TensorShape& in, const WindowParams& window) {
+    const int k = window.kernel;
+    const int out_h = outputSize(in.height, window);
+    const int out_w = outputSize(in.width, window);
+    if (cols.getRows() != in.channels * k * k || cols.getCols() != out_h * out_w) {
+        throw std::invalid_argument("col2im input does not match the layer's window.");
+    }
+
+    // Matrix::multiply always returns row-major, so the backward pass never
+    // pays for this copy; it only keeps col2im correct for other callers
+    Matrix converted;
+    const Matrix* rows = &cols;
+    if (cols.getLayout() != Matrix::Layout::RowMajor) {
+        converted = Matrix::withLayout(cols, Matrix::Layout::RowMajor);
+        rows = &converted;
+    }
+
+    Matrix result(in.size(), 1);
+    double* image = result.line(0);
+    for (int c = 0; c < in.channels; ++c) {
+        double* plane = image + c * in.height * in.width;
+        for (int ky = 0; ky < k; ++ky) {
+            for (int kx = 0; kx < k; ++kx) {
+                const double* in_row = rows->line((c * k + ky) * k + kx);
+                for (int oy = 0; oy < out_h; ++oy) {
+                    int y = oy * window.stride - window.padding + ky;
+                    if (y < 0 || y >= in.height) {
+                        continue;
+                    }
+                    for (int ox = 0; ox < out_w; ++ox) {
+                        int x = ox * window.stride - window.padding + kx;
+                        if (x >= 0 && x < in.width) {
+                            plane[y * in.width + x] += in_row[oy * out_w + ox];
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
+Matrix Conv2D::maxPool(const Matrix& input, const TensorShape& in, const WindowParams& window, std::vector<int>& argmax) {
+    const double* image = columnData(input, in.size());
+    TensorShape out = outputShape(in, in.channels, {window.kernel, window.stride, 0});
+
+    Matrix result(out.size(), 1);
+    double* pooled = result.line(0);
+    argmax.assign(out.size(), 0);
+
+    for (int c = 0; c < in.channels; ++c) {
+        for (int oy = 0; oy < out.height; ++oy) {
+            for (int ox = 0; ox < out.width; ++ox) {
+                int best = -1;
+                double best_value = -std::numeric_limits<double>::infinity();
+                for (int ky = 0; ky < window.kernel; ++ky) {
+                    for (int kx = 0; kx < window.kernel; ++kx) {
+                        int y = oy * window.stride + ky;
+                        int x = ox * window.stride + kx;
+                        int idx = (c * in.height + y) * in.width + x;
+                        if (best < 0 || image[idx] > best_value) {
+                            best = idx;
+                            best_value = image[idx];
+                        }
+                    }
+                }
+                int o = (c * out.height + oy) * out.width + ox;
+                pooled[o] = best_value;
+                argmax[o] = best;
+            }
+        }
+    }
+    return result;
+}
+
+Matrix Conv2D::maxPoolBackward(const Matrix& grad, int input_size, const std::vector<int>& argmax) {
+    const double* g = columnData(grad, argmax.size());
+    Matrix result(input_size, 1);
+    double* out = result.line(0);
+    for (int o = 0; o < argmax.size(); ++o) {
+        out[argmax[o]] += g[o];
+    }
+    return result;
+}
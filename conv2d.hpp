@@ -0,0 +1,73 @@
+#ifndef CONV2D_H
+#define CONV2D_H
+
+#include <vector>
+#include "matrix.hpp"
+
+/**
+ * @brief Shape of a layer's output when viewed as an image.
+ * Activations stay column vectors; element (c, y, x) is row
+ * (c * height + y) * width + x. Dense layers are {nodes, 1, 1}.
+ */
+struct TensorShape {
+    int channels;
+    int height;
+    int width;
+
+    int size() const { return channels * height * width; }
+};
+
+/**
+ * @brief Sliding window settings shared by convolution and pooling layers.
+ */
+struct WindowParams {
+    int kernel;
+    int stride;
+    int padding;
+};
+
+/**
+ * @brief Building blocks for convolution and max pooling layers.
+ *
+ * A convolution is lowered to a single matrix product:
+ *   output (filters x positions) = weights (filters x C*K*K) * im2col(input) (C*K*K x positions)
+ * so it runs on Matrix::multiply like the dense layers do.
+ */
+class Conv2D {
+public:
+    /**
+     * @brief Output height/width of a window sliding over one input dimension.
+     * Throws std::invalid_argument if the window doesn't fit.
+     */
+    static int outputSize(int input_size, const WindowParams& window);
+
+    static TensorShape outputShape(const TensorShape& in, int channels, const WindowParams& window);
+
+    /**
+     * @brief Unrolls every receptive field of the input into a column.
+     * @param input Column vector holding an image of shape in.
+     * @return (C*K*K) x (out_height*out_width) matrix. Padding reads as zero.
+     */
+    static Matrix im2col(const Matrix& input, const TensorShape& in, const WindowParams& window);
+
+    /**
+     * @brief Inverse scatter of im2col: sums each column entry back into the
+     * image position it was read from. Used for the input gradient.
+     * @return Column vector of shape in.
+     */
+    static Matrix col2im(const Matrix& cols, const TensorShape& in, const WindowParams& window);
+
+    /**
+     * @brief Max pooling over each channel. Padding is ignored.
+     * @param argmax Filled with the input row chosen for each output row,
+     * which is all maxPoolBackward needs.
+     */
+    static Matrix maxPool(const Matrix& input, const TensorShape& in, const WindowParams& window, std::vector<int>& argmax);
+
+    /**
+     * @brief Routes each output gradient back to the input that won the max.
+     */
+    static Matrix maxPoolBackward(const Matrix& grad, int input_size, const std::vector<int>& argmax);
+};
+
+#endif // CONV2D_H
@@ -0,0 +1,383 @@
+#include "dataParallel.hpp"
+#include <stdexcept>
+#include <iostream>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+// --- Shared Memory All-Reduce ---
+
+struct SharedMemoryCommunicator::Segment {
+    pthread_barrier_t barrier;
+};
+
+// Slots start on their own cache line, after the header
+static const std::size_t SEGMENT_HEADER_BYTES =
+    (sizeof(pthread_barrier_t) + Matrix::ALIGNMENT - 1) / Matrix::ALIGNMENT * Matrix::ALIGNMENT;
+
+SharedMemoryCommunicator::SharedMemoryCommunicator(int world_size, std::size_t capacity)
+    : segment(nullptr), mapped_bytes(0), capacity(capacity), my_rank(0), world(world_size) {
+    if (world_size <= 0 || capacity == 0) {
+        throw std::invalid_argument("Shared memory all-reduce needs at least one rank and one value.");
+    }
+    static std::atomic<int> segment_counter(0);
+    std::string name = "/nn_allreduce_" + std::to_string(::getpid()) + "_" + std::to_string(segment_counter++);
+
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("shm_open failed: " + std::string(std::strerror(errno)));
+    }
+    // One slot per rank plus one for the result
+    mapped_bytes = SEGMENT_HEADER_BYTES + (world_size + 1) * capacity * sizeof(double);
+    if (::ftruncate(fd, mapped_bytes) != 0) {
+        int err = errno;
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        throw std::runtime_error("Failed to size shared memory segment: " + std::string(std::strerror(err)));
+    }
+    void* mapped = ::mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int err = errno;
+    ::close(fd);
+    // The mapping outlives the name and is inherited by fork, so nothing is left in /dev/shm if we crash
+    ::shm_unlink(name.c_str());
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error("Failed to map shared memory segment: " + std::string(std::strerror(err)));
+    }
+    segment = static_cast<Segment*>(mapped);
+
+    pthread_barrierattr_t attr;
+    pthread_barrierattr_init(&attr);
+    pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    int rc = pthread_barrier_init(&segment->barrier, &attr, world_size);
+    pthread_barrierattr_destroy(&attr);
+    if (rc != 0) {
+        ::munmap(segment, mapped_bytes);
+        throw std::runtime_error("Failed to create process-shared barrier: " + std::string(std::strerror(rc)));
+    }
+}
+
+SharedMemoryCommunicator::~SharedMemoryCommunicator() {
+    // No pthread_barrier_destroy: if a rank was killed inside a wait, glibc's
+    // destroy blocks forever. The barrier owns nothing beyond the mapping.
+    ::munmap(segment, mapped_bytes);
+}
+
+double* SharedMemoryCommunicator::slot(int r) const {
+    char* base = reinterpret_cast<char*>(segment) + SEGMENT_HEADER_BYTES;
+    return reinterpret_cast<double*>(base) + static_cast<std::size_t>(r) * capacity;
+}
+
+double* SharedMemoryCommunicator::result() const {
+    return slot(world);
+}
+
+void SharedMemoryCommunicator::setRank(int rank) {
+    my_rank = rank;
+}
+
+int SharedMemoryCommunicator::rank() const {
+    return my_rank;
+}
+
+int SharedMemoryCommunicator::worldSize() const {
+    return world;
+}
+
+void SharedMemoryCommunicator::allReduceSum(double* values, std::size_t count) {
+    for (std::size_t offset = 0; offset < count; offset += capacity) {
+        std::size_t n = std::min(capacity, count - offset);
+        double* chunk = values + offset;
+
+        // 1. Publish this rank's values
+        std::memcpy(slot(my_rank), chunk, n * sizeof(double));
+        pthread_barrier_wait(&segment->barrier);
+
+        // 2. Reduce our slice, always adding ranks in the same order
+        std::size_t begin = n * my_rank / world;
+        std::size_t end = n * (my_rank + 1) / world;
+        double* out = result();
+        std::memcpy(out + begin, slot(0) + begin, (end - begin) * sizeof(double));
+        for (int r = 1; r < world; ++r) {
+            const double* in = slot(r);
+            for (std::size_t j = begin; j < end; ++j) {
+                out[j] += in[j];
+            }
+        }
+        pthread_barrier_wait(&segment->barrier);
+
+        // 3. Everyone reads the full result; the last barrier keeps the
+        //    slots intact until all ranks are done with this chunk
+        std::memcpy(chunk, out, n * sizeof(double));
+        pthread_barrier_wait(&segment->barrier);
+    }
+}
+
+// --- Unix Socket All-Reduce ---
+
+static void sendAll(int fd, const double* values, std::size_t count) {
+    const char* bytes = reinterpret_cast<const char*>(values);
+    std::size_t size = count * sizeof(double);
+    while (size > 0) {
+        ssize_t n = ::send(fd, bytes, size, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("All-reduce send failed: " + std::string(std::strerror(errno)));
+        }
+        bytes += n;
+        size -= n;
+    }
+}
+
+static void receiveAll(int fd, double* values, std::size_t count) {
+    char* bytes = reinterpret_cast<char*>(values);
+    std::size_t size = count * sizeof(double);
+    while (size > 0) {
+        ssize_t n = ::recv(fd, bytes, size, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            throw std::runtime_error("All-reduce peer disconnected.");
+        }
+        bytes += n;
+        size -= n;
+    }
+}
+
+SocketCommunicator::SocketCommunicator(int world_size)
+    : root_fds(world_size, -1), rank_fds(world_size, -1), my_rank(0), world(world_size) {
+    if (world_size <= 0) {
+        throw std::invalid_argument("Socket all-reduce needs at least one rank.");
+    }
+    for (int r = 1; r < world_size; ++r) {
+        int pair[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+            int err = errno;
+            for (int fd : root_fds) if (fd >= 0) ::close(fd);
+            for (int fd : rank_fds) if (fd >= 0) ::close(fd);
+            throw std::runtime_error("socketpair failed: " + std::string(std::strerror(err)));
+        }
+        root_fds[r] = pair[0];
+        rank_fds[r] = pair[1];
+    }
+}
+
+SocketCommunicator::~SocketCommunicator() {
+    for (int fd : root_fds) if (fd >= 0) ::close(fd);
+    for (int fd : rank_fds) if (fd >= 0) ::close(fd);
+}
+
+void SocketCommunicator::setRank(int rank) {
+    my_rank = rank;
+    // Keep only this rank's ends, so a dead peer shows up as end-of-file
+    for (int r = 0; r < world; ++r) {
+        if (rank != 0 && root_fds[r] >= 0) {
+            ::close(root_fds[r]);
+            root_fds[r] = -1;
+        }
+        if (r != rank && rank_fds[r] >= 0) {
+            ::close(rank_fds[r]);
+            rank_fds[r] = -1;
+        }
+    }
+}
+
+int SocketCommunicator::rank() const {
+    return my_rank;
+}
+
+int SocketCommunicator::worldSize() const {
+    return world;
+}
+
+void SocketCommunicator::allReduceSum(double* values, std::size_t count) {
+    if (my_rank != 0) {
+        sendAll(rank_fds[my_rank], values, count);
+        receiveAll(rank_fds[my_rank], values, count);
+        return;
+    }
+    // Same order as the shared memory path: ((v0 + v1) + v2) + ...
+    scratch.resize(count);
+    for (int r = 1; r < world; ++r) {
+        receiveAll(root_fds[r], scratch.data(), count);
+        for (std::size_t j = 0; j < count; ++j) {
+            values[j] += scratch[j];
+        }
+    }
+    for (int r = 1; r < world; ++r) {
+        sendAll(root_fds[r], values, count);
+    }
+}
+
+// --- Launcher ---
+
+// Restricts the calling process to its share of the CPUs it may run on.
+// CPU numbers are usually grouped by socket, so contiguous blocks keep each
+// rank (and its memory, under first-touch) on one NUMA node.
+static void pinToCpuBlock(int rank, int world) {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (::sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return;
+    }
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            cpus.push_back(cpu);
+        }
+    }
+    if (cpus.empty()) {
+        return;
+    }
+    int per_rank = std::max<int>(1, cpus.size() / world);
+    cpu_set_t mine;
+    CPU_ZERO(&mine);
+    for (int n = 0; n < per_rank; ++n) {
+        CPU_SET(cpus[(rank * per_rank + n) % cpus.size()], &mine);
+    }
+    ::sched_setaffinity(0, sizeof(mine), &mine);
+}
+
+int DataParallel::launch(const DataParallelOptions& options, const std::function<void(Communicator&)>& worker) {
+    if (options.processes <= 0) {
+        throw std::invalid_argument("Data-parallel training needs at least one process.");
+    }
+
+    std::unique_ptr<SharedMemoryCommunicator> shared;
+    std::unique_ptr<SocketCommunicator> sockets;
+    if (!options.force_sockets) {
+        try {
+            shared.reset(new SharedMemoryCommunicator(options.processes, options.max_reduce_values));
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: shared memory all-reduce unavailable (" << e.what()
+                      << "), falling back to Unix sockets." << std::endl;
+        }
+    }
+    if (!shared) {
+        sockets.reset(new SocketCommunicator(options.processes));
+    }
+
+    // Don't let children inherit (and print again) anything still buffered
+    std::cout.flush();
+    std::cerr.flush();
+
+    std::vector<pid_t> pids;
+    for (int r = 0; r < options.processes; ++r) {
+        pid_t pid = ::fork();
+        if (pid < 0) {
+            for (pid_t started : pids) {
+                ::kill(started, SIGTERM);
+                ::waitpid(started, nullptr, 0);
+            }
+            throw std::runtime_error("fork failed: " + std::string(std::strerror(errno)));
+        }
+        if (pid == 0) {
+            int status = 0;
+            try {
+                if (options.pin_cpus) {
+                    pinToCpuBlock(r, options.processes);
+                }
+                Communicator* comm;
+                if (shared) {
+                    shared->setRank(r);
+                    comm = shared.get();
+                } else {
+                    sockets->setRank(r);
+                    comm = sockets.get();
+                }
+                worker(*comm);
+            } catch (const std::exception& e) {
+                std::cerr << "Rank " << r << " failed: " << e.what() << std::endl;
+                status = 1;
+            }
+            std::cout.flush();
+            std::cerr.flush();
+            ::_exit(status); // skip the parent's destructors and atexit handlers
+        }
+        pids.push_back(pid);
+    }
+
+    // The parent only supervises; its socket ends would keep dead peers from showing EOF
+    if (sockets) {
+        sockets->setRank(-1);
+    }
+
+    bool failed = false;
+    int remaining = pids.size();
+    while (remaining > 0) {
+        int status = 0;
+        pid_t done = ::waitpid(-1, &status, 0);
+        if (done < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        std::vector<pid_t>::iterator it = std::find(pids.begin(), pids.end(), done);
+        if (it == pids.end()) {
+            continue; // not one of ours
+        }
+        *it = -1;
+        --remaining;
+        if (!(WIFEXITED(status) && WEXITSTATUS(status) == 0) && !failed) {
+            // The others would block forever in the next reduction
+            failed = true;
+            for (pid_t pid : pids) {
+                if (pid > 0) {
+                    ::kill(pid, SIGTERM);
+                }
+            }
+        }
+    }
+    return failed ? 1 : 0;
+}
+
+double DataParallel::trainEpoch(NeuralNetwork& nn, Communicator& comm, const std::vector<Matrix>& inputs,
+                                const std::vector<Matrix>& targets, int batch_size) {
+    if (inputs.size() != targets.size()) {
+        throw std::invalid_argument("Need exactly one target per input.");
+    }
+    if (batch_size <= 0) {
+        throw std::invalid_argument("Batch size must be positive.");
+    }
+
+    std::vector<double> buffer;
+    double total_loss = 0.0;
+    for (int start = 0; start < inputs.size(); start += batch_size) {
+        int end = std::min<int>(inputs.size(), start + batch_size);
+
+        // This rank's shard of the batch
+        nn.zeroGradients();
+        double batch_loss = 0.0;
+        for (int j = start; j < end; ++j) {
+            if ((j - start) % comm.worldSize() == comm.rank()) {
+                nn.feedForward(inputs[j]);
+                batch_loss += nn.backward(targets[j]);
+            }
+        }
+
+        // Reduce the loss along with the gradients, in the same message
+        nn.packGradients(buffer);
+        buffer.push_back(batch_loss);
+        comm.allReduceSum(buffer.data(), buffer.size());
+        total_loss += buffer.back();
+        buffer.pop_back();
+
+        nn.unpackGradients(buffer);
+        nn.applyGradients(1.0 / (end - start));
+    }
+    return total_loss;
+}
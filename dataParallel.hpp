@@ -0,0 +1,133 @@
+#ifndef DATAPARALLEL_H
+#define DATAPARALLEL_H
+
+#include <vector>
+#include <functional>
+#include <cstddef>
+#include "matrix.hpp"
+#include "neuralNetwork.hpp"
+
+/**
+ * @brief Connects the processes started by DataParallel::launch.
+ *
+ * allReduceSum always adds the ranks' buffers in rank order (0, 1, 2, ...),
+ * so every rank gets exactly the same bits back and replicas that apply
+ * the result stay identical.
+ */
+class Communicator {
+public:
+    virtual ~Communicator() = default;
+
+    virtual int rank() const = 0;
+    virtual int worldSize() const = 0;
+
+    /**
+     * @brief Replaces values on every rank with the element-wise sum over all ranks.
+     * Every rank must call it with the same count.
+     */
+    virtual void allReduceSum(double* values, std::size_t count) = 0;
+};
+
+/**
+ * @brief All-reduce over one POSIX shared-memory segment mapped by every rank.
+ *
+ * Each rank copies its buffer into its own slot, then sums one 1/N slice
+ * of all slots (a reduce-scatter), and finally every rank copies the whole
+ * result back (an all-gather). Process-shared barriers separate the phases.
+ */
+class SharedMemoryCommunicator : public Communicator {
+private:
+    struct Segment;
+    Segment* segment;
+    std::size_t mapped_bytes;
+    std::size_t capacity; // doubles per slot; larger reductions are done in chunks
+    int my_rank;
+    int world;
+
+    double* slot(int r) const;
+    double* result() const;
+
+public:
+    /**
+     * @brief Creates and maps the segment. Must be called before forking;
+     * throws std::runtime_error if shared memory isn't available.
+     */
+    SharedMemoryCommunicator(int world_size, std::size_t capacity);
+    ~SharedMemoryCommunicator();
+
+    SharedMemoryCommunicator(const SharedMemoryCommunicator&) = delete;
+    SharedMemoryCommunicator& operator=(const SharedMemoryCommunicator&) = delete;
+
+    void setRank(int rank); // called in each child after fork
+
+    int rank() const override;
+    int worldSize() const override;
+    void allReduceSum(double* values, std::size_t count) override;
+};
+
+/**
+ * @brief Fallback all-reduce over Unix domain sockets: rank 0 is connected to
+ * every other rank, gathers their buffers, sums them in rank order and sends
+ * the result back.
+ */
+class SocketCommunicator : public Communicator {
+private:
+    // root_fds[r] is rank 0's end of the pair shared with rank r, rank_fds[r] is rank r's end
+    std::vector<int> root_fds;
+    std::vector<int> rank_fds;
+    std::vector<double> scratch;
+    int my_rank;
+    int world;
+
+public:
+    /**
+     * @brief Creates one socket pair per non-zero rank. Must be called before forking.
+     */
+    explicit SocketCommunicator(int world_size);
+    ~SocketCommunicator();
+
+    SocketCommunicator(const SocketCommunicator&) = delete;
+    SocketCommunicator& operator=(const SocketCommunicator&) = delete;
+
+    void setRank(int rank); // called in each child after fork (-1 in the parent); closes the other ranks' sockets
+
+    int rank() const override;
+    int worldSize() const override;
+    void allReduceSum(double* values, std::size_t count) override;
+};
+
+/**
+ * @brief Settings for DataParallel::launch.
+ */
+struct DataParallelOptions {
+    int processes = 2;
+    std::size_t max_reduce_values = 1 << 20; // shared-memory slot size, in doubles
+    bool pin_cpus = false;                   // give each rank its own contiguous block of CPUs
+    bool force_sockets = false;              // skip shared memory, e.g. to test the fallback
+};
+
+/**
+ * @brief Multi-process data-parallel training on one machine.
+ */
+class DataParallel {
+public:
+    /**
+     * @brief Forks options.processes workers and runs worker(comm) in each.
+     * Each worker should build its own NeuralNetwork with the same seed so
+     * all replicas start identical.
+     * @return 0 if every worker finished normally, 1 otherwise. If one worker
+     * fails, the others are killed rather than left waiting in a reduction.
+     */
+    static int launch(const DataParallelOptions& options, const std::function<void(Communicator&)>& worker);
+
+    /**
+     * @brief Trains one epoch. In each batch, sample j goes to rank j % worldSize,
+     * the ranks' gradients are all-reduced and every replica applies the
+     * batch average.
+     * @return The summed loss over all samples, identical on every rank.
+     */
+    static double trainEpoch(NeuralNetwork& nn, Communicator& comm, const std::vector<Matrix>& inputs,
+                             const std::vector<Matrix>& targets, int batch_size);
+};
+
+#endif // DATAPARALLEL_H
@@ -0,0 +1,249 @@
+#include "gemmTuner.hpp"
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include <iostream>
+#include <set>
+
+// Products below this many multiply-adds finish faster than a cache lookup pays off
+static const long long GEMM_MIN_TUNED_WORK = 1 << 14;
+// Each candidate runs until it has used this much time, and at least GEMM_MIN_RUNS times
+static const double GEMM_BENCH_SECONDS = 0.02;
+static const int GEMM_MIN_RUNS = 3;
+
+static const char* GEMM_CACHE_HEADER = "# gemm tuning cache v1";
+
+static unsigned int hardwareThreads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+GemmTuner::GemmTuner() : loaded(false), table(nullptr) {
+    const char* env_path = std::getenv("NN_GEMM_CACHE");
+    cache_path = env_path ? env_path : "gemm_tuning.cache";
+    publishLocked(Table());
+}
+
+GemmTuner& GemmTuner::instance() {
+    static GemmTuner tuner;
+    return tuner;
+}
+
+GemmTuner::Key GemmTuner::keyOf(const GemmShape& shape) {
+    return Key(shape.m, shape.n, shape.k, shape.a_col_major, shape.b_col_major);
+}
+
+void GemmTuner::setCachePath(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mtx);
+    cache_path = path;
+    publishLocked(Table());
+    loaded.store(false);
+}
+
+void GemmTuner::publishLocked(Table next) {
+    // Old versions stay allocated: a lookup on another thread may still be
+    // reading one. There is one per load, tune() or tuneAll(), so few of them.
+    versions.emplace_back(new Table(std::move(next)));
+    table.store(versions.back().get());
+}
+
+// --- Cache File ---
+
+void GemmTuner::load() {
+    std::lock_guard<std::mutex> lock(mtx);
+    loadLocked();
+}
+
+void GemmTuner::loadLocked() {
+    if (loaded.load()) {
+        return;
+    }
+    publishLocked(readCacheFile());
+    loaded.store(true);
+}
+
+GemmTuner::Table GemmTuner::readCacheFile() const {
+    Table entries;
+    std::ifstream in(cache_path);
+    if (!in) {
+        return entries; // not tuned on this machine yet
+    }
+
+    std::string line;
+    if (!std::getline(in, line) || line.rfind(GEMM_CACHE_HEADER, 0) != 0) {
+        std::cerr << "Warning: ignoring unrecognised GEMM tuning cache " << cache_path << std::endl;
+        return entries;
+    }
+    // Timings from a machine with a different core count don't apply here
+    unsigned int threads = 0;
+    std::sscanf(line.c_str() + std::string(GEMM_CACHE_HEADER).size(), " threads=%u", &threads);
+    if (threads != hardwareThreads()) {
+        std::cerr << "Warning: GEMM tuning cache " << cache_path << " was made for "
+                  << threads << " threads, ignoring it." << std::endl;
+        return entries;
+    }
+
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        GemmShape shape;
+        GemmConfig config;
+        if (fields >> shape.m >> shape.n >> shape.k >> shape.a_col_major >> shape.b_col_major
+                   >> config.block >> config.threads >> config.pack) {
+            entries[keyOf(shape)] = config;
+        }
+    }
+    return entries;
+}
+
+void GemmTuner::saveLocked() const {
+    // Write a temporary file and rename it, so readers never see half a cache
+    std::string tmp_path = cache_path + ".tmp";
+    {
+        std::ofstream out(tmp_path);
+        if (!out) {
+            throw std::runtime_error("Failed to write GEMM tuning cache " + tmp_path);
+        }
+        out << GEMM_CACHE_HEADER << " threads=" << hardwareThreads() << "\n";
+        out << "# m n k a_col_major b_col_major block threads pack\n";
+        for (const std::pair<const Key, GemmConfig>& entry : *table.load()) {
+            const Key& key = entry.first;
+            const GemmConfig& config = entry.second;
+            out << std::get<0>(key) << " " << std::get<1>(key) << " " << std::get<2>(key) << " "
+                << std::get<3>(key) << " " << std::get<4>(key) << " "
+                << config.block << " " << config.threads << " " << config.pack << "\n";
+        }
+        if (!out) {
+            throw std::runtime_error("Failed to write GEMM tuning cache " + tmp_path);
+        }
+    }
+    if (std::rename(tmp_path.c_str(), cache_path.c_str()) != 0) {
+        throw std::runtime_error("Failed to replace GEMM tuning cache " + cache_path);
+    }
+}
+
+// --- Lookup ---
+
+bool GemmTuner::lookup(const GemmShape& shape, GemmConfig& config) {
+    if (static_cast<long long>(shape.m) * shape.n * shape.k < GEMM_MIN_TUNED_WORK) {
+        return false;
+    }
+    if (!loaded.load()) {
+        std::lock_guard<std::mutex> lock(mtx);
+        loadLocked();
+    }
+    const Table* current = table.load();
+    Table::const_iterator it = current->find(keyOf(shape));
+    if (it == current->end()) {
+        return false;
+    }
+    config = it->second;
+    return true;
+}
+
+// --- Tuning ---
+
+std::vector<GemmConfig> GemmTuner::candidates(const GemmShape& shape) {
+    std::vector<int> thread_counts = {1};
+    for (int t = 2; t < hardwareThreads(); t *= 2) {
+        thread_counts.push_back(t);
+    }
+    if (hardwareThreads() > 1) {
+        thread_counts.push_back(hardwareThreads());
+    }
+
+    std::vector<bool> pack_options = {false};
+    if (shape.a_col_major || shape.b_col_major) {
+        pack_options.push_back(true);
+    }
+
+    std::vector<GemmConfig> result;
+    for (bool pack : pack_options) {
+        // Tiling only affects the row-major kernel
+        bool row_major_kernel = (pack || !shape.a_col_major) && (pack || !shape.b_col_major);
+        std::vector<int> blocks = {0};
+        if (row_major_kernel) {
+            blocks.push_back(32);
+            blocks.push_back(128);
+        }
+        for (int block : blocks) {
+            for (int threads : thread_counts) {
+                if (threads > shape.m) {
+                    break; // threads split rows; extra ones would sit idle
+                }
+                GemmConfig config;
+                config.block = block;
+                config.threads = threads;
+                config.pack = pack;
+                result.push_back(config);
+            }
+        }
+    }
+    return result;
+}
+
+GemmConfig GemmTuner::benchmark(const GemmShape& shape) {
+    Matrix a(shape.m, shape.k, shape.a_col_major ? Matrix::Layout::ColMajor : Matrix::Layout::RowMajor);
+    Matrix b(shape.k, shape.n, shape.b_col_major ? Matrix::Layout::ColMajor : Matrix::Layout::RowMajor);
+    a.randomize(-1.0, 1.0, 1, 0);
+    b.randomize(-1.0, 1.0, 1, 1);
+
+    GemmConfig best;
+    double best_seconds = -1.0;
+    for (const GemmConfig& config : candidates(shape)) {
+        Matrix::multiply(a, b, config); // warm up caches and page in the result
+        int runs = 0;
+        auto start = std::chrono::steady_clock::now();
+        double elapsed = 0.0;
+        while (runs < GEMM_MIN_RUNS || elapsed < GEMM_BENCH_SECONDS) {
+            Matrix::multiply(a, b, config);
+            ++runs;
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        double seconds = elapsed / runs;
+        if (best_seconds < 0 || seconds < best_seconds) {
+            best_seconds = seconds;
+            best = config;
+        }
+    }
+    return best;
+}
+
+GemmConfig GemmTuner::tune(const GemmShape& shape) {
+    GemmConfig best = benchmark(shape);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    loadLocked();
+    Table next = *table.load();
+    next[keyOf(shape)] = best;
+    publishLocked(std::move(next));
+    return best;
+}
+
+int GemmTuner::tuneAll(const std::vector<GemmShape>& shapes, bool retune) {
+    Table results;
+    std::set<Key> seen;
+    for (const GemmShape& shape : shapes) {
+        GemmConfig existing;
+        if (static_cast<long long>(shape.m) * shape.n * shape.k < GEMM_MIN_TUNED_WORK) {
+            continue; // never looked up, see lookup()
+        }
+        if (!seen.insert(keyOf(shape)).second || (!retune && lookup(shape, existing))) {
+            continue;
+        }
+        results[keyOf(shape)] = benchmark(shape);
+    }
+
+    // One new version for the whole batch, so tuning S shapes copies the table once
+    std::lock_guard<std::mutex> lock(mtx);
+    loadLocked(); // keep entries for shapes outside this list
+    Table next = *table.load();
+    for (const std::pair<const Key, GemmConfig>& entry : results) {
+        next[entry.first] = entry.second;
+    }
+    publishLocked(std::move(next));
+    saveLocked();
+    return results.size();
+}
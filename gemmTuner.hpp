@@ -0,0 +1,99 @@
+#ifndef GEMMTUNER_H
+#define GEMMTUNER_H
+
+#include <vector>
+#include <string>
+#include <map>
+#include <tuple>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include "matrix.hpp"
+
+/**
+ * @brief One matrix product as Matrix::multiply sees it:
+ * (m x k) * (k x n), plus how each operand is stored.
+ */
+struct GemmShape {
+    int m;
+    int n;
+    int k;
+    bool a_col_major;
+    bool b_col_major;
+};
+
+/**
+ * @brief Picks the fastest GemmConfig for each product shape and remembers it.
+ *
+ * tuneAll() benchmarks every candidate for each shape and saves the winners
+ * to a text cache file (NN_GEMM_CACHE, or "gemm_tuning.cache" in the working
+ * directory). Matrix::multiply calls lookup() on every product; the cache is
+ * read once, on the first lookup. Products too small to benefit skip the
+ * lookup and use the default single-threaded kernel.
+ *
+ * The table is copy-on-write: tuning publishes a new version with one atomic
+ * store, so after the first load lookup() never takes a lock and is safe to
+ * call from threads that must not block.
+ */
+class GemmTuner {
+private:
+    using Key = std::tuple<int, int, int, bool, bool>;
+    using Table = std::map<Key, GemmConfig>;
+
+    std::mutex mtx; // serialises loading, tuning and saving; lookups skip it
+    std::atomic<bool> loaded;
+    std::string cache_path;
+    std::atomic<const Table*> table;
+    std::vector<std::unique_ptr<const Table>> versions; // every published table, kept for the process lifetime
+
+    GemmTuner();
+    void publishLocked(Table next);
+    void loadLocked(); // reads the cache file unless that already happened
+    Table readCacheFile() const;
+    void saveLocked() const;
+    static Key keyOf(const GemmShape& shape);
+    static GemmConfig benchmark(const GemmShape& shape);
+
+public:
+    static GemmTuner& instance();
+
+    GemmTuner(const GemmTuner&) = delete;
+    GemmTuner& operator=(const GemmTuner&) = delete;
+
+    /**
+     * @brief Uses a different cache file. Entries from the old file are dropped.
+     */
+    void setCachePath(const std::string& path);
+
+    /**
+     * @brief Reads the cache file now rather than on the first lookup(), so
+     * threads that must not block never end up doing it.
+     */
+    void load();
+
+    /**
+     * @brief Finds the tuned configuration for a shape.
+     * @return false (and leaves config alone) if the shape hasn't been tuned.
+     */
+    bool lookup(const GemmShape& shape, GemmConfig& config);
+
+    /**
+     * @brief Every configuration worth trying for a shape: tile sizes, thread
+     * counts up to the core count, and packing when an operand is column-major.
+     */
+    static std::vector<GemmConfig> candidates(const GemmShape& shape);
+
+    /**
+     * @brief Benchmarks all candidates on random operands and records the fastest.
+     */
+    GemmConfig tune(const GemmShape& shape);
+
+    /**
+     * @brief Tunes every shape not in the cache yet (or all of them if retune
+     * is set), then writes the cache file.
+     * @return The number of shapes benchmarked.
+     */
+    int tuneAll(const std::vector<GemmShape>& shapes, bool retune = false);
+};
+
+#endif // GEMMTUNER_H
@@ -3,19 +3,95 @@
 #include <iomanip> 
 #include <cmath> 
 #include <cassert> 
+#include <thread>
+#include <algorithm>
 #include "matrix.hpp"
+#include "philox.hpp"
+#include "gemmTuner.hpp"
+
+// Below this many elements per thread, spawning threads costs more than filling
+static const int RANDOMIZE_MIN_ELEMENTS_PER_THREAD = 1 << 15;
+
+// Leading dimensions are padded to a whole number of cache lines
+static const int DOUBLES_PER_LINE = Matrix::ALIGNMENT / sizeof(double);
+// Strides that are a multiple of 4 KiB map every row to the same cache sets
+static const int CONFLICT_STRIDE = 4096 / sizeof(double);
+
+// --- Element-wise Helpers ---
+
+// Applies op to every element of m in place, walking the stored lines directly
+template <typename Op>
+static void applyInPlace(Matrix& m, Op op) {
+    for (int i = 0; i < m.lineCount(); ++i) {
+        double* values = m.line(i);
+        for (int j = 0; j < m.lineLength(); ++j) {
+            values[j] = op(values[j]);
+        }
+    }
+}
+
+// Returns op(m) element by element, in m's layout
+template <typename Op>
+static Matrix mapped(const Matrix& m, Op op) {
+    Matrix result = m;
+    applyInPlace(result, op);
+    return result;
+}
+
+// Sets a to op(a, b) element by element
+template <typename Op>
+static void combineInPlace(Matrix& a, const Matrix& b, Op op) {
+    if (a.getLayout() == b.getLayout()) {
+        for (int i = 0; i < a.lineCount(); ++i) {
+            double* a_values = a.line(i);
+            const double* b_values = b.line(i);
+            for (int j = 0; j < a.lineLength(); ++j) {
+                a_values[j] = op(a_values[j], b_values[j]);
+            }
+        }
+    } else {
+        for (int i = 0; i < a.getRows(); ++i) {
+            for (int j = 0; j < a.getCols(); ++j) {
+                a(i, j) = op(a(i, j), b(i, j));
+            }
+        }
+    }
+}
+
+// Returns op(a, b) element by element, in a's layout
+template <typename Op>
+static Matrix combined(const Matrix& a, const Matrix& b, Op op) {
+    Matrix result = a;
+    combineInPlace(result, b, op);
+    return result;
+}
 
-Matrix::Matrix() : row(0), col(0) {
+Matrix::Matrix() : row(0), col(0), ld(0), layout(Layout::RowMajor) {
     // Default constructor: creates an empty 0x0 matrix.
     // The data vector is left empty by default.
 }
 
-Matrix::Matrix(int rows, int cols) : row(rows), col(cols) {
+Matrix::Matrix(int rows, int cols, Layout layout) : row(rows), col(cols), layout(layout) {
     if (rows <= 0 || cols <= 0) {
         throw std::invalid_argument("Matrix dimensions must be positive.");
     }
-    // Resize the single vector to hold all elements, initialized to 0.0
-    data.resize(rows * cols, 0.0);
+    ld = paddedLeadingDim(lineLength());
+    // Resize the single vector to hold all lines, initialized to 0.0.
+    // Padding stays 0.0 for the lifetime of the matrix.
+    data.resize(static_cast<std::size_t>(lineCount()) * ld, 0.0);
+}
+
+int Matrix::paddedLeadingDim(int length) {
+    // Lines shorter than a cache line (vectors, narrow matrices) are stored
+    // densely: padding them would multiply their size for no aligned loads
+    if (length < DOUBLES_PER_LINE) {
+        return length;
+    }
+    int padded = (length + DOUBLES_PER_LINE - 1) / DOUBLES_PER_LINE * DOUBLES_PER_LINE;
+    if (padded % CONFLICT_STRIDE == 0) {
+        padded += DOUBLES_PER_LINE;
+    }
+    return padded;
 }
 
 int Matrix::getRows() const {
@@ -26,18 +102,26 @@ int Matrix::getCols() const {
     return col;
 }
 
+int Matrix::getLeadingDim() const {
+    return ld;
+}
+
+Matrix::Layout Matrix::getLayout() const {
+    return layout;
+}
+
 double& Matrix::operator()(int r, int c) {
     if (r < 0 || r >= row || c < 0 || c >= col) {
         throw std::out_of_range("Matrix subscript out of bounds.");
     }
-    return data[r * col + c];
+    return at(r, c);
 }
 
 const double& Matrix::operator()(int r, int c) const {
     if (r < 0 || r >= row || c < 0 || c >= col) {
         throw std::out_of_range("Matrix subscript out of bounds.");
     }
-    return data[r * col + c];
+    return at(r, c);
 }
 
 
@@ -56,107 +140,107 @@ void Matrix::print() const {
 
 void Matrix::randomize() {
     std::random_device rd;
-    std::mt19937 gen(rd());
+    std::uint64_t seed = (static_cast<std::uint64_t>(rd()) << 32) | rd();
     // Distribution between -1.0 and 1.0
-    std::uniform_real_distribution<> dis(-1.0, 1.0);
+    randomize(-1.0, 1.0, seed, 0);
+}
 
-    for (int i = 0; i < row; ++i) {
-        for (int j = 0; j < col; ++j) {
-            // Use the operator() accessor to set the value
-            (*this)(i, j) = dis(gen);
+void Matrix::randomize(double low, double high, std::uint64_t seed, std::uint64_t stream, int threads) {
+    const Philox rng(seed, stream);
+    const double range = high - low;
+
+    // Element (i, j) always takes value number i * col + j of the stream, so
+    // neither the thread split nor the storage layout changes the result.
+    auto fillRows = [this, &rng, low, range](int first_row, int last_row) {
+        for (int i = first_row; i < last_row; ++i) {
+            for (int j = 0; j < col; ++j) {
+                std::uint64_t index = static_cast<std::uint64_t>(i) * col + j;
+                at(i, j) = low + range * rng.uniform(index);
+            }
         }
+    };
+
+    long long total = static_cast<long long>(row) * col;
+    int thread_count = threads > 0 ? threads : static_cast<int>(std::min<long long>(
+        std::max(1u, std::thread::hardware_concurrency()),
+        std::max(1LL, total / RANDOMIZE_MIN_ELEMENTS_PER_THREAD)));
+    thread_count = std::min(thread_count, std::max(row, 1));
+
+    if (thread_count <= 1) {
+        fillRows(0, row);
+        return;
     }
-}
 
-void Matrix::fill(double value) {
-    for (int i = 0; i < row; ++i) {
-        for (int j = 0; j < col; ++j) {
-            // Use the operator() accessor to set the value
-            (*this)(i, j) = value;
+    std::vector<std::thread> workers;
+    int rows_per_thread = (row + thread_count - 1) / thread_count;
+    for (int t = 0; t < thread_count; ++t) {
+        int first_row = t * rows_per_thread;
+        int last_row = std::min(row, first_row + rows_per_thread);
+        if (first_row >= last_row) {
+            break;
         }
+        workers.emplace_back(fillRows, first_row, last_row);
     }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void Matrix::fill(double value) {
+    applyInPlace(*this, [value](double) { return value; });
 }
 
 double Matrix::sum() const {
+    // Always adds in row order, so both layouts round the same way
     double total = 0.0;
-    for (double val : data) { //iterates through every member of the array data 
-        total += val;
+    if (layout == Layout::ColMajor && col > 1) {
+        for (int i = 0; i < row; ++i) {
+            for (int j = 0; j < col; ++j) {
+                total += at(i, j);
+            }
+        }
+        return total;
+    }
+    for (int i = 0; i < lineCount(); ++i) { // padding is skipped, only real elements count
+        const double* values = line(i);
+        for (int j = 0; j < lineLength(); ++j) {
+            total += values[j];
+        }
     }
     return total;
 }
 
 void Matrix::scale(double scalar) {
-    for (int i = 0; i < row; ++i) {
-        for (int j = 0; j < col; ++j) {
-            (*this)(i, j) *= scalar;
-        }
-    }
+    applyInPlace(*this, [scalar](double val) { return val * scalar; });
 }
 
 // --- Activation Functions ---
 
 void Matrix::sigmoid() {
-    for (int i = 0; i < row; ++i) {
-        for (int j = 0; j < col; ++j) {
-            double& val = (*this)(i, j); // Get reference
-            val = 1.0 / (1.0 + exp(-val));
-        }
-    }
+    applyInPlace(*this, [](double val) { return 1.0 / (1.0 + exp(-val)); });
 }
 
 void Matrix::reLu() {
-    for (int i = 0; i < row; ++i) {
-        for (int j = 0; j < col; ++j) {
-            double& val = (*this)(i, j); // Get reference
-            if (val > 0) {
-                val = val;
-            } else {
-                val = 0;
-            }
-        }
-    }
+    applyInPlace(*this, [](double val) { return val > 0 ? val : 0.0; });
 }
 
 Matrix Matrix::dSigmoid() {
-    Matrix result(row, col);
-    for (int i = 0; i < row; ++i) {
-        for (int j = 0; j < col; ++j) {
-            // Derivative is: sigmoid(x) * (1 - sigmoid(x))
-            // We assume 'this' matrix already has sigmoid applied.
-            double val = (*this)(i, j);
-            result(i, j) = val * (1.0 - val);
-        }
-    }
-    return result;
+    // Derivative is: sigmoid(x) * (1 - sigmoid(x))
+    // We assume 'this' matrix already has sigmoid applied.
+    return mapped(*this, [](double val) { return val * (1.0 - val); });
 }
 
 
 Matrix Matrix::sigmoid_nonDestructive(const Matrix& m) {
-    Matrix result(m.row, m.col);
-    for (int i = 0; i < m.data.size(); ++i) {
-        result.data[i] = 1.0 / (1.0 + exp(-m.data[i]));
-    }
-    return result;
+    return mapped(m, [](double val) { return 1.0 / (1.0 + exp(-val)); });
 }
 
 Matrix Matrix::dsigmoid_nonDestructive(const Matrix& m) {
-    Matrix result(m.row, m.col);
-    for (int i = 0; i < m.data.size(); ++i) {
-        result.data[i] = m.data[i] * (1.0 - m.data[i]);
-    }
-    return result;
+    return mapped(m, [](double val) { return val * (1.0 - val); });
 };
 
 Matrix Matrix::dreLu_nonDestructive(const Matrix& m) {
-    Matrix result(m.row, m.col);
-    for (int i = 0; i < m.data.size(); ++i) {
-        if (m.data[i] > 0) {
-            result.data[i] = 1;
-        } else {
-            result.data[i] = 0;
-        }
-    }
-    return result;
+    return mapped(m, [](double val) { return val > 0 ? 1.0 : 0.0; });
 };
 
 
@@ -166,65 +250,183 @@ Matrix Matrix::add(const Matrix& a, const Matrix& b) {
     if (a.row != b.row || a.col != b.col) {
         throw std::invalid_argument("Matrix dimensions must match for addition.");
     }
-    Matrix result(a.row, a.col);
-    for (int i = 0; i < a.row; ++i) {
-        for (int j = 0; j < a.col; ++j) {
-            // Use const accessor for a & b, non-const for result
-            result(i, j) = a(i, j) + b(i, j);
-        }
-    }
-    return result;
+    return combined(a, b, [](double x, double y) { return x + y; });
 }
 
 Matrix Matrix::subtract(const Matrix& a, const Matrix& b) {
     if (a.row != b.row || a.col != b.col) {
         throw std::invalid_argument("Matrix dimensions must match for subtraction.");
     }
-    Matrix result(a.row, a.col);
-    for (int i = 0; i < a.row; ++i) {
-        for (int j = 0; j < a.col; ++j) {
-            result(i, j) = a(i, j) - b(i, j);
-        }
+    return combined(a, b, [](double x, double y) { return x - y; });
+}
+
+void Matrix::addInPlace(const Matrix& b) {
+    if (row != b.row || col != b.col) {
+        throw std::invalid_argument("Matrix dimensions must match for addition.");
     }
-    return result;
+    combineInPlace(*this, b, [](double x, double y) { return x + y; });
+}
+
+void Matrix::subtractInPlace(const Matrix& b) {
+    if (row != b.row || col != b.col) {
+        throw std::invalid_argument("Matrix dimensions must match for subtraction.");
+    }
+    combineInPlace(*this, b, [](double x, double y) { return x - y; });
 }
 
 Matrix Matrix::multiply(const Matrix& a, const Matrix& b) {
+    GemmConfig config;
+    GemmTuner::instance().lookup({a.row, b.col, a.col, a.layout == Layout::ColMajor, b.layout == Layout::ColMajor}, config);
+    return multiply(a, b, config);
+}
+
+Matrix Matrix::multiply(const Matrix& a, const Matrix& b, const GemmConfig& config) {
     if (a.col != b.row) {
         throw std::invalid_argument("Matrix inner dimensions must match for multiplication.");
     }
     Matrix result(a.row, b.col);
-    for (int i = 0; i < result.row; ++i) {
-        for (int j = 0; j < result.col; ++j) {
+
+    // Packing trades one copy for the cache-friendly row-major kernel
+    Matrix packed_a;
+    Matrix packed_b;
+    const Matrix* left = &a;
+    const Matrix* right = &b;
+    if (config.pack && a.layout == Layout::ColMajor) {
+        packed_a = withLayout(a, Layout::RowMajor);
+        left = &packed_a;
+    }
+    if (config.pack && b.layout == Layout::ColMajor) {
+        packed_b = withLayout(b, Layout::RowMajor);
+        right = &packed_b;
+    }
+
+    int thread_count = std::min(config.threads, result.row);
+    if (thread_count <= 1) {
+        multiplyRows(*left, *right, result, 0, result.row, config.block);
+        return result;
+    }
+
+    // Threads own disjoint rows of the result, so no locking is needed
+    std::vector<std::thread> workers;
+    int rows_per_thread = (result.row + thread_count - 1) / thread_count;
+    for (int t = 0; t < thread_count; ++t) {
+        int first_row = t * rows_per_thread;
+        int last_row = std::min(result.row, first_row + rows_per_thread);
+        if (first_row >= last_row) {
+            break;
+        }
+        workers.emplace_back(multiplyRows, std::cref(*left), std::cref(*right), std::ref(result), first_row, last_row, config.block);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    return result;
+}
+
+// Every kernel below adds the products for result(i, j) in increasing k,
+// starting from 0.0, so they all return exactly the same bits. Tuning
+// changes speed, never results.
+void Matrix::multiplyRows(const Matrix& a, const Matrix& b, Matrix& result, int first_row, int last_row, int block) {
+    const int inner = a.col;
+
+    if (a.layout == Layout::RowMajor && result.col == 1) {
+        // Matrix * vector: one dot product per row, summed in a register
+        // rather than through out[0] in memory
+        const double* b_values = b.line(0);
+        const int b_stride = b.layout == Layout::RowMajor ? b.ld : 1;
+        for (int i = first_row; i < last_row; ++i) {
+            const double* a_row = a.line(i);
             double sum = 0.0;
-            for (int k = 0; k < a.col; ++k) {
-                sum += a(i, k) * b(k, j);
+            for (int k = 0; k < inner; ++k) {
+                sum += a_row[k] * b_values[k * b_stride];
+            }
+            result.at(i, 0) = sum;
+        }
+    } else if (a.layout == Layout::RowMajor && b.layout == Layout::RowMajor) {
+        // i-k-j order: the inner loop streams along rows of b and result.
+        // Tiling k and j keeps a block of b in cache while it is reused for every row.
+        const int k_block = block > 0 ? block : inner;
+        const int j_block = block > 0 ? block : result.col;
+        for (int kk = 0; kk < inner; kk += k_block) {
+            const int k_end = std::min(inner, kk + k_block);
+            for (int jj = 0; jj < result.col; jj += j_block) {
+                const int j_end = std::min(result.col, jj + j_block);
+                for (int i = first_row; i < last_row; ++i) {
+                    const double* a_row = a.line(i);
+                    double* out = result.line(i);
+                    for (int k = kk; k < k_end; ++k) {
+                        const double a_ik = a_row[k];
+                        const double* b_row = b.line(k);
+                        for (int j = jj; j < j_end; ++j) {
+                            out[j] += a_ik * b_row[j];
+                        }
+                    }
+                }
+            }
+        }
+    } else if (a.layout == Layout::RowMajor) {
+        // Rows of a and columns of b are both contiguous: plain dot products
+        for (int i = first_row; i < last_row; ++i) {
+            const double* a_row = a.line(i);
+            for (int j = 0; j < result.col; ++j) {
+                const double* b_col = b.line(j);
+                double sum = 0.0;
+                for (int k = 0; k < inner; ++k) {
+                    sum += a_row[k] * b_col[k];
+                }
+                result.at(i, j) = sum;
+            }
+        }
+    } else {
+        // Column-major a: accumulate whole columns of a into each result column
+        for (int j = 0; j < result.col; ++j) {
+            for (int k = 0; k < inner; ++k) {
+                const double b_kj = b.at(k, j);
+                const double* a_col = a.line(k);
+                for (int i = first_row; i < last_row; ++i) {
+                    result.at(i, j) += a_col[i] * b_kj;
+                }
             }
-            result(i, j) = sum;
         }
     }
-    return result;
 }
 
 Matrix Matrix::multiplyElementWise(const Matrix& a, const Matrix& b) {
     if (a.row != b.row || a.col != b.col) {
         throw std::invalid_argument("Matrix dimensions must match for element-wise multiplication.");
     }
-    Matrix result(a.row, a.col);
+    return combined(a, b, [](double x, double y) { return x * y; });
+}
+
+Matrix Matrix::transpose(const Matrix& a) {
+    // Row i of a is column i of the result, so the stored lines can be reused as-is
+    Matrix result = a;
+    result.row = a.col;
+    result.col = a.row;
+    result.layout = (a.layout == Layout::RowMajor) ? Layout::ColMajor : Layout::RowMajor;
+    return result;
+}
+
+Matrix Matrix::withLayout(const Matrix& a, Layout layout) {
+    if (a.layout == layout || a.row == 0) {
+        return a;
+    }
+    Matrix result(a.row, a.col, layout);
     for (int i = 0; i < a.row; ++i) {
         for (int j = 0; j < a.col; ++j) {
-            result(i, j) = a(i, j) * b(i, j);
+            result.at(i, j) = a.at(i, j);
         }
     }
     return result;
 }
 
-Matrix Matrix::transpose(const Matrix& a) {
-    Matrix result(a.col, a.row);
-    for (int i = 0; i < a.row; ++i) {
-        for (int j = 0; j < a.col; ++j) {
-            result(j, i) = a(i, j);
-        }
+Matrix Matrix::reshape(const Matrix& a, int rows, int cols) {
+    if (static_cast<long long>(rows) * cols != static_cast<long long>(a.row) * a.col) {
+        throw std::invalid_argument("Reshape must keep the number of elements.");
+    }
+    Matrix result(rows, cols);
+    for (int n = 0; n < rows * cols; ++n) {
+        result.at(n / cols, n % cols) = a.at(n / a.col, n % a.col);
     }
     return result;
 }
@@ -232,7 +434,7 @@ Matrix Matrix::transpose(const Matrix& a) {
 Matrix Matrix::fromVector(const std::vector<double>& vec) {
     Matrix result(vec.size(), 1);
     for (int i = 0; i < vec.size(); ++i) {
-        result(i, 0) = vec[i];
+        result.at(i, 0) = vec[i];
     }
     return result;
 }
@@ -242,6 +444,7 @@ std::vector<double> Matrix::toVector() const {
         std::cerr << "Warning: toVector() called on matrix with more than one column." << std::endl;
     }
     std::vector<double> result;
+    result.reserve(row);
     for (int i = 0; i < row; ++i) {
         result.push_back((*this)(i, 0)); // Use const accessor
     }
@@ -4,29 +4,121 @@
 #include <vector>
 #include <iostream>
 #include <random>
+#include <cstdint>
+#include <cstddef>
+#include <new>
 #include <stdexcept> // For std::out_of_range
 
-class Matrix 
+/**
+ * @brief Allocator returning memory aligned to Alignment bytes, so every
+ * row of a Matrix can start on a cache line.
+ *
+ * Buffers under MinAlignedBytes (the small vectors training creates on
+ * every step) come from plain operator new instead: over-aligned
+ * allocation costs several times more, and a buffer that short has no
+ * lines worth aligning.
+ */
+template <typename T, std::size_t Alignment, std::size_t MinAlignedBytes = 4 * Alignment>
+struct AlignedAllocator
 {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind { using other = AlignedAllocator<U, Alignment, MinAlignedBytes>; };
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment, MinAlignedBytes>&) {}
+
+    //deallocate gets the same n as allocate, so both pick the same path
+    T* allocate(std::size_t n) {
+        if (n * sizeof(T) < MinAlignedBytes) {
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+    void deallocate(T* p, std::size_t n) {
+        if (n * sizeof(T) < MinAlignedBytes) {
+            ::operator delete(p);
+            return;
+        }
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment, MinAlignedBytes>&) const { return true; }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment, MinAlignedBytes>&) const { return false; }
+};
+
+/**
+ * @brief How Matrix::multiply computes one product. The autotuner
+ * (gemmTuner.hpp) picks the fastest one per shape.
+ */
+struct GemmConfig
+{
+    int block = 0;     //k and j tile size for the row-major kernel, 0 = no tiling
+    int threads = 1;   //result rows are split between this many threads
+    bool pack = false; //copy column-major operands to row-major first, instead of using the layout's own kernel
+};
+
+class Matrix
+{
+    public:
+        /**
+         * RowMajor stores each row contiguously, ColMajor each column.
+         * Consecutive rows (columns) are getLeadingDim() doubles apart.
+         */
+        enum class Layout { RowMajor, ColMajor };
+
+        static const int ALIGNMENT = 64; //bytes, one cache line
+
     private:
-        std::vector<double> data;
+        std::vector<double, AlignedAllocator<double, ALIGNMENT>> data;
         int row;
         int col;
+        int ld; //leading dimension: stride between rows (RowMajor) or columns (ColMajor)
+        Layout layout;
+
+        static int paddedLeadingDim(int length);
+
+        //Unchecked element access, for loops that already know they are in bounds
+        int index(int r, int c) const { return layout == Layout::RowMajor ? r * ld + c : c * ld + r; }
+        double& at(int r, int c) { return data[index(r, c)]; }
+        const double& at(int r, int c) const { return data[index(r, c)]; }
+
+        //Computes rows [first_row, last_row) of result = a * b
+        static void multiplyRows(const Matrix& a, const Matrix& b, Matrix& result, int first_row, int last_row, int block);
+
     public:
         Matrix();
-        Matrix(int rows, int cols);
+        Matrix(int rows, int cols, Layout layout = Layout::RowMajor);
 
         int getRows() const;
         int getCols() const;
+        int getLeadingDim() const;
+        Layout getLayout() const;
+
+        //Number of stored lines (rows for RowMajor, columns for ColMajor) and their length
+        int lineCount() const { return layout == Layout::RowMajor ? row : col; }
+        int lineLength() const { return layout == Layout::RowMajor ? col : row; }
+
+        //Pointer to the start of a stored line; 64-byte aligned whenever getLeadingDim() is a multiple of 8
+        //and the matrix holds at least 256 bytes (see AlignedAllocator)
+        double* line(int i) { return data.data() + static_cast<std::size_t>(i) * ld; }
+        const double* line(int i) const { return data.data() + static_cast<std::size_t>(i) * ld; }
 
         double& operator()(int r, int c); //To get data position, since not using vector of vectors
         const double& operator()(int r, int c) const;
 
-        void print() const; //print function for debugging matrix content 
+        void print() const; //print function for debugging matrix content
         void randomize(); //generate random values for the starting matrix
+        void randomize(double low, double high, std::uint64_t seed, std::uint64_t stream, int threads = 0); //seeded, same result for any thread count (0 = pick from the core count)
         void fill(double value);
 
         void scale(double scalar); //Scales all values within the matrix
+        void addInPlace(const Matrix& b); //this += b, without a temporary
+        void subtractInPlace(const Matrix& b); //this -= b, without a temporary
         double sum() const;
 
         void sigmoid();
@@ -40,15 +132,18 @@ class Matrix
 
         static Matrix add(const Matrix& a, const Matrix& b);
         static Matrix subtract(const Matrix& a, const Matrix& b);
-        static Matrix multiply(const Matrix& a, const Matrix& b);
+        static Matrix multiply(const Matrix& a, const Matrix& b); //uses the tuned kernel for this shape, if there is one
+        static Matrix multiply(const Matrix& a, const Matrix& b, const GemmConfig& config);
         static Matrix multiplyElementWise(const Matrix& a, const Matrix& b);
-        static Matrix transpose(const Matrix& a);
+        static Matrix transpose(const Matrix& a); //O(1) apart from the copy: flips the layout instead of moving elements
+        static Matrix withLayout(const Matrix& a, Layout layout); //copy of a stored in the given layout
+        static Matrix reshape(const Matrix& a, int rows, int cols); //same elements read in row-major order, new shape
 
         static Matrix fromVector(const std::vector<double>& vec);
         std::vector<double> toVector() const;
     };
-    
-    
+
+
 Matrix operator+(const Matrix& a, const Matrix& b);
 
 Matrix operator-(const Matrix& a, const Matrix& b);
@@ -1,59 +1,195 @@
 #include "neuralNetwork.hpp"
 #include <stdexcept>
 #include <iostream>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <iomanip>
 
 // --- Constructor ---
 
-NeuralNetwork::NeuralNetwork(double learning_rate) {
+NeuralNetwork::NeuralNetwork(double learning_rate, std::uint64_t seed) {
     this->training_rate = learning_rate;
     this->momentum = 0.9;
+    this->seed = seed;
 }
 
-void NeuralNetwork::addLayer(int node_count, const std::string& activation) {
-    // 1. Store the new layer's info
-    layer_nodes.push_back(node_count);
+NeuralNetwork::Activation NeuralNetwork::activationFromName(const std::string& name) {
+    if (name == "sigmoid") {
+        return Activation::Sigmoid;
+    }
+    if (name == "reLu") {
+        return Activation::ReLu;
+    }
+    return Activation::Other;
+}
+
+const char* NeuralNetwork::layerKindName(LayerKind kind) {
+    switch (kind) {
+        case LayerKind::Input: return "input";
+        case LayerKind::Dense: return "dense";
+        case LayerKind::Conv2D: return "conv2d";
+        case LayerKind::MaxPool: return "maxpool";
+    }
+    return "unknown";
+}
+
+void NeuralNetwork::initializeWeights(Matrix& w, int fan_in, int fan_out, const std::string& activation, std::uint64_t stream) const {
+    double limit;
+    if (activation == "reLu") {
+        // He: keeps activation variance stable when half the units are zeroed
+        limit = std::sqrt(6.0 / fan_in);
+    } else {
+        // Xavier/Glorot: balances forward and backward variance for sigmoid
+        limit = std::sqrt(6.0 / (fan_in + fan_out));
+    }
+    w.randomize(-limit, limit, seed, stream);
+}
+
+void NeuralNetwork::appendLayer(LayerKind kind, const TensorShape& shape, const WindowParams& window, const std::string& activation) {
+    layer_nodes.push_back(shape.size());
     layer_activations.push_back(activation);
+    layer_activation_kinds.push_back(activationFromName(activation));
+    layer_kinds.push_back(kind);
+    layer_shapes.push_back(shape);
+    layer_windows.push_back(window);
 
-    // 2. Resize the 'activations' vector to make room for this layer's output
-    //    We do this every time to keep it in sync with layer_nodes.
+    // Resize the 'activations' vector to make room for this layer's output
+    // We do this every time to keep it in sync with layer_nodes.
     activations.resize(layer_nodes.size());
+}
+
+void NeuralNetwork::appendParameters(int rows, int cols, int fan_in, int fan_out, const std::string& activation) {
+    im2col_cache.emplace_back();
+    pool_argmax.emplace_back();
+    sparse_weights.emplace_back();
+    use_sparse.push_back(false);
+
+    if (rows == 0) {
+        weights.emplace_back();
+        biases.emplace_back();
+        weight_velocities.emplace_back();
+        bias_velocities.emplace_back();
+        weight_gradients.emplace_back();
+        bias_gradients.emplace_back();
+        return;
+    }
+
+    // Create new weight matrix: (rows x cols)
+    Matrix w(rows, cols);
+    initializeWeights(w, fan_in, fan_out, activation, weights.size());
+    weights.push_back(w); // Add to our list of weight matrices
+
+    // Create new bias vector: (rows x 1)
+    // Xavier/He assume zero biases; reLu keeps a small offset so units start active
+    Matrix b(rows, 1);
+    if (activation == "reLu") {
+        b.fill(0.001);
+    } else {            
+        b.fill(0.0);
+    }
+    biases.push_back(b); // Add to our list of bias matrices
+
+    Matrix vw(rows, cols);
+    vw.fill(0.0);
+    weight_velocities.push_back(vw);
 
-    // 3. If this is the *first* layer (Input Layer), we don't create weights.
+    Matrix vb(rows, 1);
+    vb.fill(0.0);
+    bias_velocities.push_back(vb);
+
+    weight_gradients.push_back(vw);
+    bias_gradients.push_back(vb);
+}
+
+void NeuralNetwork::addLayer(int node_count, const std::string& activation) {
+    // 1. Store the new layer's info. A dense layer is an image of node_count 1x1 channels.
+    LayerKind kind = layer_nodes.empty() ? LayerKind::Input : LayerKind::Dense;
+    appendLayer(kind, {node_count, 1, 1}, {0, 0, 0}, activation);
+
+    // 2. If this is the *first* layer (Input Layer), we don't create weights.
     //    We only create weights *connecting* layers.
     if (layer_nodes.size() > 1) {
         // This is a hidden or output layer.
         // We must create the weights and biases connecting the *previous* layer
-        // to *this* new layer.
-        
+        // to *this* new layer: (current_layer_nodes x prev_layer_nodes)
         int prev_layer_node_count = layer_nodes[layer_nodes.size() - 2];
-        int curr_layer_node_count = node_count; // same as layer_nodes.back()
+        appendParameters(node_count, prev_layer_node_count, prev_layer_node_count, node_count, activation);
+    }
+}
 
-        // Create new weight matrix: (current_layer_nodes x prev_layer_nodes)
-        Matrix w(curr_layer_node_count, prev_layer_node_count);
-        w.randomize();
-        weights.push_back(w); // Add to our list of weight matrices
+void NeuralNetwork::addInputLayer(int channels, int height, int width) {
+    if (!layer_nodes.empty()) {
+        throw std::logic_error("The input layer must be added first.");
+    }
+    appendLayer(LayerKind::Input, {channels, height, width}, {0, 0, 0}, "input");
+}
 
-        // Create new bias vector: (current_layer_nodes x 1)
-        Matrix b(curr_layer_node_count, 1);
-        if (activation == "reLu") {
-            b.fill(0.001);
-        } else {            
-            b.randomize();
-        }
-        biases.push_back(b); // Add to our list of bias matrices
+void NeuralNetwork::addConv2D(int filters, int kernel_size, int stride, int padding, const std::string& activation) {
+    if (layer_nodes.empty()) {
+        throw std::logic_error("Add an input layer before a convolution.");
+    }
+    TensorShape in = layer_shapes.back();
+    WindowParams window = {kernel_size, stride, padding};
+    appendLayer(LayerKind::Conv2D, Conv2D::outputShape(in, filters, window), window, activation);
 
-        Matrix vw(curr_layer_node_count, prev_layer_node_count);
-        vw.fill(0.0);
-        weight_velocities.push_back(vw);
+    // One row of weights per filter, one column per input value in its window
+    int window_size = in.channels * kernel_size * kernel_size;
+    appendParameters(filters, window_size, window_size, filters * kernel_size * kernel_size, activation);
+}
 
-        Matrix vb(curr_layer_node_count, 1);
-        vb.fill(0.0);
-        bias_velocities.push_back(vb);
+void NeuralNetwork::addMaxPool2D(int pool_size, int stride) {
+    if (layer_nodes.empty()) {
+        throw std::logic_error("Add an input layer before pooling.");
     }
+    TensorShape in = layer_shapes.back();
+    WindowParams window = {pool_size, stride, 0};
+    appendLayer(LayerKind::MaxPool, Conv2D::outputShape(in, in.channels, window), window, "none");
+    appendParameters(0, 0, 0, 0, "none");
 }
 
 // --- Core Functions ---
 
+Matrix NeuralNetwork::forwardLayer(int i, const Matrix& input, Matrix& unrolled, std::vector<int>& argmax) const {
+    const LayerKind kind = layer_kinds[i + 1]; // +1 because [0] is input
+    Matrix layer_output;
+
+    if (kind == LayerKind::MaxPool) {
+        // pooling has no bias or activation
+        return Conv2D::maxPool(input, layer_shapes[i], layer_windows[i + 1], argmax);
+    }
+    else if (kind == LayerKind::Conv2D) {
+        // (filters x window) * (window x positions), then one bias per filter
+        unrolled = Conv2D::im2col(input, layer_shapes[i], layer_windows[i + 1]);
+        Matrix maps = weights[i] * unrolled;
+        for (int f = 0; f < maps.getRows(); ++f) {
+            double* values = maps.line(f);
+            double bias = biases[i](f, 0);
+            for (int p = 0; p < maps.getCols(); ++p) {
+                values[p] += bias;
+            }
+        }
+        layer_output = Matrix::reshape(maps, maps.getRows() * maps.getCols(), 1);
+    }
+    else if (use_sparse[i]) {
+        layer_output = SparseMatrix::multiply(sparse_weights[i], input);
+        layer_output = layer_output + biases[i];
+    }
+    else {
+        layer_output = weights[i] * input; 
+        layer_output = layer_output + biases[i];
+    }
+    const Activation act_func = layer_activation_kinds[i + 1];
+
+    if (act_func == Activation::Sigmoid) {
+        layer_output.sigmoid(); // Use in-place sigmoid
+    }
+    else if (act_func == Activation::ReLu) {
+        layer_output.reLu();
+    }
+    return layer_output;
+}
+
 Matrix NeuralNetwork::feedForward(const Matrix& input) {
     // Check if input dimensions are correct
     if (input.getRows() != layer_nodes[0] || input.getCols() != 1) {
@@ -65,25 +201,58 @@ Matrix NeuralNetwork::feedForward(const Matrix& input) {
 
     // Loop through each layer (starting after the input layer)
     for (int i = 0; i < weights.size(); ++i) {        
-        Matrix layer_output = weights[i] * activations[i]; 
-        layer_output = layer_output + biases[i];
-        std::string act_func = layer_activations[i + 1]; // +1 because [0] is input
-        
-        if (act_func == "sigmoid") {
-            layer_output.sigmoid(); // Use in-place sigmoid
-        }
-        else if (act_func == "reLu") {
-            layer_output.reLu();
-        }
-        
-        activations[i+1] = layer_output;
+        activations[i+1] = forwardLayer(i, activations[i], im2col_cache[i], pool_argmax[i]);
     }
 
     // Return reference to the final output (last activation)
     return activations.back();
 }
 
+Matrix NeuralNetwork::predict(const Matrix& input) const {
+    if (input.getRows() != layer_nodes[0] || input.getCols() != 1) {
+        throw std::invalid_argument("Input matrix has incorrect dimensions for this network.");
+    }
+
+    // Same as feedForward, but the scratch is local so concurrent calls are safe
+    Matrix current = input;
+    Matrix unrolled;
+    std::vector<int> argmax;
+    for (int i = 0; i < weights.size(); ++i) {
+        current = forwardLayer(i, current, unrolled, argmax);
+    }
+    return current;
+}
+
+NeuralNetwork NeuralNetwork::inferenceCopy() const {
+    NeuralNetwork copy(training_rate, seed);
+    copy.momentum = momentum;
+    copy.layer_nodes = layer_nodes;
+    copy.layer_activations = layer_activations;
+    copy.layer_activation_kinds = layer_activation_kinds;
+    copy.layer_kinds = layer_kinds;
+    copy.layer_shapes = layer_shapes;
+    copy.layer_windows = layer_windows;
+    copy.weights = weights;
+    copy.biases = biases;
+    copy.sparse_weights = sparse_weights;
+    copy.use_sparse = use_sparse;
+    copy.activations.resize(layer_nodes.size());
+    copy.im2col_cache.resize(weights.size());
+    copy.pool_argmax.resize(weights.size());
+    return copy;
+}
+
 double NeuralNetwork::update(const Matrix& target) {
+    // The CSR copies can't follow the weight updates below
+    dropSparseWeights();
+    return backpropagate(target, false);
+}
+
+double NeuralNetwork::backward(const Matrix& target) {
+    return backpropagate(target, true);
+}
+
+double NeuralNetwork::backpropagate(const Matrix& target, bool accumulate) {
     
     Matrix output = activations.back();
     Matrix error = target - activations.back();
@@ -92,16 +261,23 @@ double NeuralNetwork::update(const Matrix& target) {
     double total_loss = 0.5 * squared_error.sum();
 
     for (int i = weights.size() - 1; i >= 0; --i) {
+        const LayerKind kind = layer_kinds[i + 1];
+
+        if (kind == LayerKind::MaxPool) {
+            // No parameters: just send the error back to the winning inputs
+            negativeError = Conv2D::maxPoolBackward(negativeError, layer_nodes[i], pool_argmax[i]);
+            continue;
+        }
 
         Matrix current_output = activations[i + 1];
         Matrix derivative;
-        std::string act_func = layer_activations[i + 1]; // +1 because [0] is input
+        const Activation act_func = layer_activation_kinds[i + 1]; // +1 because [0] is input
 
-        if (act_func == "sigmoid") {
+        if (act_func == Activation::Sigmoid) {
             derivative = Matrix::dsigmoid_nonDestructive(current_output);
         }
         // --- BONUS (This is where you'd add more) ---
-        else if (act_func == "reLu") {
+        else if (act_func == Activation::ReLu) {
              derivative = Matrix::dreLu_nonDestructive(current_output);
         }
         else {
@@ -114,44 +290,328 @@ double NeuralNetwork::update(const Matrix& target) {
         Matrix scaled_gradient = unscaled_gradient;
         scaled_gradient.scale(this->training_rate);
 
-        Matrix prev_activation_T = Matrix::transpose(activations[i]);
-        Matrix delta_weights = scaled_gradient * prev_activation_T;
+        Matrix delta_weights;
+        Matrix delta_biases;
+
+        if (kind == LayerKind::Conv2D) {
+            // Same as dense, with positions playing the role of a batch:
+            // gradients are (filters x positions) and the input is im2col_cache[i]
+            int filters = weights[i].getRows();
+            int positions = layer_shapes[i + 1].height * layer_shapes[i + 1].width;
+            Matrix gradient_maps = Matrix::reshape(unscaled_gradient, filters, positions);
+            Matrix scaled_maps = Matrix::reshape(scaled_gradient, filters, positions);
 
-        Matrix weights_T = Matrix::transpose(weights[i]);
-        negativeError = weights_T * unscaled_gradient;
+            delta_weights = scaled_maps * Matrix::transpose(im2col_cache[i]);
+            Matrix ones(positions, 1);
+            ones.fill(1.0);
+            delta_biases = scaled_maps * ones; // sum over positions
+
+            Matrix weights_T = Matrix::transpose(weights[i]);
+            negativeError = Conv2D::col2im(weights_T * gradient_maps, layer_shapes[i], layer_windows[i + 1]);
+        }
+        else {
+            Matrix prev_activation_T = Matrix::transpose(activations[i]);
+            delta_weights = scaled_gradient * prev_activation_T;
+            delta_biases = scaled_gradient;
+
+            Matrix weights_T = Matrix::transpose(weights[i]);
+            negativeError = weights_T * unscaled_gradient;
+        }
         
+        if (accumulate) {
+            // Summing 0.0 + delta is exact, so applyGradients(1.0) matches update()
+            weight_gradients[i].addInPlace(delta_weights);
+            bias_gradients[i].addInPlace(delta_biases);
+            continue;
+        }
+
         /*//Momentum Code
         weight_velocities[i].scale(this->momentum);
         weight_velocities[i] = weight_velocities[i] - delta_weights;
         bias_velocities[i].scale(this->momentum);
-        bias_velocities[i] = bias_velocities[i] - scaled_gradient;
+        bias_velocities[i] = bias_velocities[i] - delta_biases;
 
         // 2. Update weights using the new velocities instead of the raw gradient
         weights[i] = weights[i] + weight_velocities[i];
         biases[i]  = biases[i] + bias_velocities[i]; */
 
         //Standard SGD Code:
-        weights[i] = weights[i] - delta_weights;
-        biases[i] = biases[i] - scaled_gradient;
+        weights[i].subtractInPlace(delta_weights);
+        biases[i].subtractInPlace(delta_biases);
     }
 
     return total_loss; 
 }
 
+// params -= scale * steps, then steps = 0, in one pass over both
+static void applyAndClear(Matrix& params, Matrix& steps, double scale) {
+    if (params.getLayout() != steps.getLayout()) {
+        for (int r = 0; r < params.getRows(); ++r) {
+            for (int c = 0; c < params.getCols(); ++c) {
+                params(r, c) -= scale * steps(r, c);
+                steps(r, c) = 0.0;
+            }
+        }
+        return;
+    }
+    for (int i = 0; i < params.lineCount(); ++i) {
+        double* values = params.line(i);
+        double* step = steps.line(i);
+        for (int j = 0; j < params.lineLength(); ++j) {
+            values[j] -= scale * step[j]; // scale 1.0 is exact, same as update()
+            step[j] = 0.0;
+        }
+    }
+}
+
+void NeuralNetwork::applyGradients(double scale) {
+    // The CSR copies can't follow the weight updates below
+    dropSparseWeights();
+
+    for (int i = 0; i < weights.size(); ++i) {
+        if (weights[i].getRows() == 0) {
+            continue; // pooling layer, nothing to update
+        }
+        //Standard SGD step; see backpropagate() for the momentum variant
+        applyAndClear(weights[i], weight_gradients[i], scale);
+        applyAndClear(biases[i], bias_gradients[i], scale);
+    }
+}
+
+void NeuralNetwork::zeroGradients() {
+    for (int i = 0; i < weight_gradients.size(); ++i) {
+        weight_gradients[i].fill(0.0);
+        bias_gradients[i].fill(0.0);
+    }
+}
+
+int NeuralNetwork::gradientCount() const {
+    int count = 0;
+    for (int i = 0; i < weight_gradients.size(); ++i) {
+        count += weight_gradients[i].getRows() * weight_gradients[i].getCols();
+        count += bias_gradients[i].getRows() * bias_gradients[i].getCols();
+    }
+    return count;
+}
+
+// Walks every gradient matrix in a fixed order, so pack and unpack agree
+template <typename Group, typename Visit>
+static void forEachGradient(Group& weight_gradients, Group& bias_gradients, Visit visit) {
+    for (Group* group : {&weight_gradients, &bias_gradients}) {
+        for (auto& m : *group) {
+            for (int i = 0; i < m.lineCount(); ++i) {
+                visit(m.line(i), m.lineLength());
+            }
+        }
+    }
+}
+
+void NeuralNetwork::packGradients(std::vector<double>& out) const {
+    out.resize(gradientCount());
+    double* dst = out.data();
+    forEachGradient(weight_gradients, bias_gradients, [&dst](const double* values, int length) {
+        std::copy(values, values + length, dst);
+        dst += length;
+    });
+}
+
+void NeuralNetwork::unpackGradients(const std::vector<double>& in) {
+    if (in.size() < gradientCount()) {
+        throw std::invalid_argument("Gradient buffer is smaller than the network's gradients.");
+    }
+    const double* src = in.data();
+    forEachGradient(weight_gradients, bias_gradients, [&src](double* values, int length) {
+        std::copy(src, src + length, values);
+        src += length;
+    });
+}
+
+void NeuralNetwork::dropSparseWeights() {
+    for (int i = 0; i < use_sparse.size(); ++i) {
+        if (use_sparse[i]) {
+            use_sparse[i] = false;
+            sparse_weights[i] = SparseMatrix();
+        }
+    }
+}
+
+// --- Pruning ---
+
+// Average time of one call to fn, in microseconds
+template <typename Fn>
+static double timeMicroseconds(Fn fn) {
+    const int repetitions = 20;
+    fn(); // warm up caches
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repetitions; ++r) {
+        fn();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::micro>(elapsed).count() / repetitions;
+}
+
+// Index of the largest entry of a column vector
+static int argMax(const Matrix& m) {
+    int best = 0;
+    for (int i = 1; i < m.getRows(); ++i) {
+        if (m(i, 0) > m(best, 0)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+double NeuralNetwork::evaluateAccuracy(const std::vector<Matrix>& inputs, const std::vector<Matrix>& targets) {
+    if (inputs.size() != targets.size()) {
+        throw std::invalid_argument("Need exactly one target per input.");
+    }
+    if (inputs.empty()) {
+        return -1.0;
+    }
+    int correct = 0;
+    for (int n = 0; n < inputs.size(); ++n) {
+        if (argMax(feedForward(inputs[n])) == argMax(targets[n])) {
+            ++correct;
+        }
+    }
+    return static_cast<double>(correct) / inputs.size();
+}
+
+std::vector<LayerPruneReport> NeuralNetwork::prune(double threshold, int keep_top_k, double min_sparsity,
+                                                   const std::vector<Matrix>& inputs, const std::vector<Matrix>& targets) {
+    std::vector<LayerPruneReport> report;
+    double accuracy = evaluateAccuracy(inputs, targets);
+
+    for (int i = 0; i < weights.size(); ++i) {
+        if (layer_kinds[i + 1] != LayerKind::Dense) {
+            continue; // conv filters are small and shared; pruning them doesn't pay off
+        }
+        Matrix& w = weights[i];
+        std::vector<std::pair<double, int>> row_magnitudes(w.getCols());
+
+        for (int r = 0; r < w.getRows(); ++r) {
+            double* row_values = w.line(r);
+            for (int c = 0; c < w.getCols(); ++c) {
+                if (std::abs(row_values[c]) < threshold) {
+                    row_values[c] = 0.0;
+                }
+                row_magnitudes[c] = {std::abs(row_values[c]), c};
+            }
+            if (keep_top_k > 0 && keep_top_k < w.getCols()) {
+                // Move the k largest to the front; everything after them is dropped
+                std::nth_element(row_magnitudes.begin(), row_magnitudes.begin() + keep_top_k, row_magnitudes.end(),
+                                 [](const std::pair<double, int>& a, const std::pair<double, int>& b) { return a.first > b.first; });
+                for (int n = keep_top_k; n < row_magnitudes.size(); ++n) {
+                    row_values[row_magnitudes[n].second] = 0.0;
+                }
+            }
+        }
+
+        LayerPruneReport layer_report;
+        layer_report.layer = i + 1;
+        layer_report.accuracy_before = accuracy;
+
+        SparseMatrix sparse = SparseMatrix::fromDense(w);
+        layer_report.non_zeros = sparse.nonZeros();
+        layer_report.sparsity = sparse.sparsity();
+
+        // Time both kernels on a real activation if we have one
+        Matrix x = activations[i];
+        if (x.getRows() != layer_nodes[i]) {
+            x = Matrix(layer_nodes[i], 1);
+            x.fill(1.0);
+        }
+        layer_report.dense_us = timeMicroseconds([&] { Matrix y = w * x; });
+        layer_report.sparse_us = timeMicroseconds([&] { Matrix y = SparseMatrix::multiply(sparse, x); });
+
+        // Fall back to dense when the layer isn't sparse enough for CSR to win
+        layer_report.uses_sparse = layer_report.sparsity >= min_sparsity && layer_report.sparse_us < layer_report.dense_us;
+        use_sparse[i] = layer_report.uses_sparse;
+        sparse_weights[i] = layer_report.uses_sparse ? sparse : SparseMatrix();
+
+        accuracy = evaluateAccuracy(inputs, targets);
+        layer_report.accuracy_after = accuracy;
+        report.push_back(layer_report);
+    }
+    return report;
+}
+
+void NeuralNetwork::printPruneReport(const std::vector<LayerPruneReport>& report) {
+    std::cout << "--- Pruning Report ---" << std::endl;
+    for (const LayerPruneReport& r : report) {
+        std::cout << std::fixed << std::setprecision(2)
+                  << "Layer " << r.layer << ": " << r.non_zeros << " weights left, "
+                  << 100.0 * r.sparsity << "% sparse, "
+                  << (r.uses_sparse ? "CSR" : "dense") << ", "
+                  << "speedup " << (r.sparse_us > 0 ? r.dense_us / r.sparse_us : 0.0) << "x";
+        if (r.accuracy_before >= 0) {
+            std::cout << ", accuracy " << 100.0 * r.accuracy_before << "% -> " << 100.0 * r.accuracy_after << "%";
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "----------------------" << std::endl;
+}
+
+std::vector<GemmShape> NeuralNetwork::gemmShapes() const {
+    std::vector<GemmShape> shapes;
+    for (int i = 0; i < weights.size(); ++i) {
+        int out = weights[i].getRows();
+        int in = weights[i].getCols();
+        if (layer_kinds[i + 1] == LayerKind::Conv2D) {
+            int positions = layer_shapes[i + 1].height * layer_shapes[i + 1].width;
+            shapes.push_back({out, positions, in, false, false});   // weights * im2col
+            shapes.push_back({out, in, positions, false, true});    // gradient maps * im2col^T
+            shapes.push_back({out, 1, positions, false, false});    // bias gradient: maps * ones
+            shapes.push_back({in, positions, out, true, false});    // weights^T * gradient maps
+        }
+        else if (layer_kinds[i + 1] == LayerKind::Dense) {
+            shapes.push_back({out, 1, in, false, false});           // weights * activation
+            shapes.push_back({out, in, 1, false, true});            // gradient * activation^T
+            shapes.push_back({in, 1, out, true, false});            // weights^T * gradient
+        }
+    }
+
+    // Layers of the same size share shapes
+    std::vector<GemmShape> unique;
+    for (const GemmShape& shape : shapes) {
+        bool seen = false;
+        for (const GemmShape& other : unique) {
+            seen = seen || (other.m == shape.m && other.n == shape.n && other.k == shape.k &&
+                            other.a_col_major == shape.a_col_major && other.b_col_major == shape.b_col_major);
+        }
+        if (!seen) {
+            unique.push_back(shape);
+        }
+    }
+    return unique;
+}
+
 // --- Utility Functions ---
 const Matrix& NeuralNetwork::getActivationAt(int layer) const {
 
     return activations[layer];
 };
 
+bool NeuralNetwork::usesSparse(int layer) const {
+    return use_sparse.at(layer - 1);
+}
+
 void NeuralNetwork::print() const {
     std::cout << "--- Network Topology ---" << std::endl;
     for (int i = 0; i < layer_nodes.size(); ++i) {
-        std::cout << "Layer " << i << ": " << layer_nodes[i] << " nodes" << std::endl;
+        std::cout << "Layer " << i << ": " << layer_nodes[i] << " nodes";
+        if (layer_kinds[i] == LayerKind::Conv2D || layer_kinds[i] == LayerKind::MaxPool || layer_shapes[i].height > 1) {
+            std::cout << " (" << layerKindName(layer_kinds[i]) << " " << layer_shapes[i].channels << "x"
+                      << layer_shapes[i].height << "x" << layer_shapes[i].width << ")";
+        }
+        std::cout << std::endl;
     }
     std::cout << "------------------------" << std::endl;
 
     for (int i = 0; i < weights.size(); ++i) {
+        if (layer_kinds[i + 1] == LayerKind::MaxPool) {
+            continue; // no parameters
+        }
         std::cout << "Weights (Layer " << i << " to " << i+1 << "): " 
                   << weights[i].getRows() << "x" << weights[i].getCols() << std::endl;
         std::cout << "Biases (for Layer " << i+1 << "): "
@@ -2,11 +2,48 @@
 #define NEURALNETWORK_H
 
 #include <vector>
+#include <string>
+#include <cstdint>
 #include "matrix.hpp"
+#include "conv2d.hpp"
+#include "sparseMatrix.hpp"
+#include "gemmTuner.hpp"
+
+/**
+ * @brief What prune() did to one dense layer.
+ */
+struct LayerPruneReport {
+    int layer;              // index of the layer the weights feed into
+    int non_zeros;          // weights left after pruning
+    double sparsity;        // fraction of weights that are zero
+    bool uses_sparse;       // whether feedForward now uses the CSR kernel
+    double dense_us;        // time of one dense weights * activation product
+    double sparse_us;       // time of the same product with the CSR weights
+    double accuracy_before; // on the evaluation set, -1 if none was given
+    double accuracy_after;
+};
 
 
 class NeuralNetwork {
+    // Reads and restores parameters and optimizer state
+    friend class Checkpointer;
+    // Publishes trimmed copies for its readers (inferenceCopy)
+    friend class OnlineLearner;
+
 private:
+    // --- Layer Descriptions ---
+
+    // Resolved from strings once, in addLayer(), so the per-sample loops
+    // compare enums instead of strings
+    enum class LayerKind { Input, Dense, Conv2D, MaxPool };
+
+    // Other covers "input", "none" and unknown names: no activation going
+    // forward, and (as always) the sigmoid derivative going back
+    enum class Activation { Sigmoid, ReLu, Other };
+
+    static Activation activationFromName(const std::string& name);
+    static const char* layerKindName(LayerKind kind);
+
     // --- Member Variables ---
 
     /**
@@ -14,7 +51,28 @@ private:
      */
     std::vector<int> layer_nodes;
 
+    /**
+     * @brief Activation names as given to addLayer(), and the same resolved
+     * to an enum for the training loops.
+     */
     std::vector<std::string> layer_activations;
+    std::vector<Activation> layer_activation_kinds;
+
+    /**
+     * @brief How each layer is computed from the previous one.
+     */
+    std::vector<LayerKind> layer_kinds;
+
+    /**
+     * @brief Each layer's output viewed as channels x height x width.
+     * layer_nodes[i] == layer_shapes[i].size().
+     */
+    std::vector<TensorShape> layer_shapes;
+
+    /**
+     * @brief Kernel/stride/padding of conv2d and maxpool layers (unused otherwise).
+     */
+    std::vector<WindowParams> layer_windows;
 
     /**
      * @brief A list of Weight matrices. weights[i] is the matrix
@@ -33,15 +91,88 @@ private:
      */
     std::vector<Matrix> activations;
 
+    /**
+     * @brief Per-layer scratch from the last feedForward, needed by update().
+     * im2col_cache[i] is the unrolled input of conv layer i+1 and
+     * pool_argmax[i] the winning inputs of maxpool layer i+1.
+     */
+    std::vector<Matrix> im2col_cache;
+    std::vector<std::vector<int>> pool_argmax;
+
     /**
      * @brief The learning rate for backpropagation.
      */
 
     std::vector<Matrix> weight_velocities;
     std::vector<Matrix> bias_velocities;   
+
+    /**
+     * @brief Weight and bias steps summed by backward() since the last
+     * applyGradients(), already multiplied by the learning rate.
+     */
+    std::vector<Matrix> weight_gradients;
+    std::vector<Matrix> bias_gradients;
+
+    /**
+     * @brief CSR copies of pruned weights. When use_sparse[i] is set,
+     * feedForward multiplies by sparse_weights[i] instead of weights[i].
+     */
+    std::vector<SparseMatrix> sparse_weights;
+    std::vector<bool> use_sparse;
     double training_rate;
     double momentum;
 
+    /**
+     * @brief Seed for weight initialization. Each weight matrix draws from
+     * its own Philox stream, so the same seed gives the same network.
+     * Biases start at a constant (0.0, or 0.001 for reLu) and use no stream.
+     */
+    std::uint64_t seed;
+
+    /**
+     * @brief Fills a weight matrix using Xavier (sigmoid and others) or
+     * He (reLu) uniform initialization, chosen from the layer's activation.
+     */
+    void initializeWeights(Matrix& w, int fan_in, int fan_out, const std::string& activation, std::uint64_t stream) const;
+
+    /**
+     * @brief Records a new layer's description and makes room for its activation.
+     */
+    void appendLayer(LayerKind kind, const TensorShape& shape, const WindowParams& window, const std::string& activation);
+
+    /**
+     * @brief Creates the weights, biases and velocities feeding the newest layer.
+     * Layers without parameters (maxpool) get empty 0x0 matrices so that
+     * weights[i] still connects layer i to layer i+1.
+     */
+    void appendParameters(int rows, int cols, int fan_in, int fan_out, const std::string& activation);
+
+    /**
+     * @brief Backpropagates the last input. Steps the weights directly, or
+     * with accumulate set adds the steps to the gradient buffers instead.
+     */
+    double backpropagate(const Matrix& target, bool accumulate);
+
+    /**
+     * @brief Sends every layer back to the dense kernel. Called whenever
+     * the dense weights change, since the CSR copies would be stale.
+     */
+    void dropSparseWeights();
+
+    /**
+     * @brief Computes layer i+1's output from layer i's.
+     * @param unrolled Receives the im2col matrix of a conv layer.
+     * @param argmax Receives the winning inputs of a maxpool layer.
+     */
+    Matrix forwardLayer(int i, const Matrix& input, Matrix& unrolled, std::vector<int>& argmax) const;
+
+    /**
+     * @brief Copies what predict() and feedForward() need: topology, weights,
+     * biases and the CSR kernels, with empty per-layer scratch. Gradient
+     * buffers and velocities are left out, so the copy cannot be trained.
+     */
+    NeuralNetwork inferenceCopy() const;
+
 public:
     // --- Constructor ---
 
@@ -50,11 +181,36 @@ public:
      * @param topology A vector of integers defining the nodes in each layer,
      * from input to output (e.g., {4, 8, 16}).
      * @param learning_rate The learning rate to use for training.
+     * @param seed Seed for weight initialization, for reproducible runs.
      */
-    NeuralNetwork(double learning_rate);
+    NeuralNetwork(double learning_rate, std::uint64_t seed = 42);
 
+    /**
+     * @brief Adds a fully connected layer (or the input layer, if it is the first).
+     */
     void addLayer(int node_count, const std::string& activation);
 
+    /**
+     * @brief Adds an image input layer. Inputs are still column vectors of
+     * channels*height*width values, stored channel by channel, row by row.
+     */
+    void addInputLayer(int channels, int height, int width);
+
+    /**
+     * @brief Adds a 2D convolution over the previous layer's image.
+     * @param filters Number of output channels.
+     * @param kernel_size Width and height of each square filter.
+     * @param stride Step between neighbouring windows.
+     * @param padding Zero padding added on every border.
+     * @param activation "reLu", "sigmoid", ...
+     */
+    void addConv2D(int filters, int kernel_size, int stride, int padding, const std::string& activation);
+
+    /**
+     * @brief Adds a max pooling layer with square windows, applied per channel.
+     */
+    void addMaxPool2D(int pool_size, int stride);
+
     // --- Core Functions ---
 
     /**
@@ -64,6 +220,12 @@ public:
      */
     Matrix feedForward(const Matrix& input);
 
+    /**
+     * @brief Same output as feedForward, but keeps nothing for update(),
+     * so any number of threads can call it on a network nobody is modifying.
+     */
+    Matrix predict(const Matrix& input) const;
+
     /**
      * @brief Updates the network's weights and biases using backpropagation.
      * @param target The expected "correct" output for the last input.
@@ -71,10 +233,74 @@ public:
      */
     double update(const Matrix& target);
 
+    /**
+     * @brief Backpropagates the last input like update(), but only adds the
+     * steps to the gradient buffers. Lets several samples (or processes)
+     * contribute to one step.
+     * @param target The expected "correct" output for the last input.
+     * @return The calculated loss (error) for this sample.
+     */
+    double backward(const Matrix& target);
+
+    /**
+     * @brief Applies the accumulated gradients, then clears them.
+     * @param scale Multiplies the summed steps, e.g. 1/batch_size for an average.
+     */
+    void applyGradients(double scale);
+
+    void zeroGradients();
+
+    /**
+     * @brief Number of values in all weight and bias gradients.
+     */
+    int gradientCount() const;
+
+    /**
+     * @brief Copies all gradients into one flat buffer (resized to
+     * gradientCount()), e.g. for an all-reduce, and back.
+     */
+    void packGradients(std::vector<double>& out) const;
+    void unpackGradients(const std::vector<double>& in);
+
+    // --- Pruning ---
+
+    /**
+     * @brief Zeroes small weights in every dense layer and switches layers
+     * that became sparse enough to a CSR inference kernel. Training with
+     * update() afterwards puts the layers back on the dense kernel.
+     * @param threshold Weights with magnitude below this become zero.
+     * @param keep_top_k If positive, also keep only the k largest weights of each row.
+     * @param min_sparsity Layers below this sparsity stay dense.
+     * @param inputs Optional evaluation inputs, used for accuracy and as the timing workload.
+     * @param targets One-hot targets matching inputs.
+     * @return One report per dense layer, in order.
+     */
+    std::vector<LayerPruneReport> prune(double threshold, int keep_top_k, double min_sparsity,
+                                        const std::vector<Matrix>& inputs, const std::vector<Matrix>& targets);
+
+    /**
+     * @brief Fraction of inputs whose largest output matches the largest target entry.
+     */
+    double evaluateAccuracy(const std::vector<Matrix>& inputs, const std::vector<Matrix>& targets);
+
+    static void printPruneReport(const std::vector<LayerPruneReport>& report);
+
+    /**
+     * @brief Every matrix product shape feedForward() and update() run, for
+     * GemmTuner::tuneAll(). Shapes are listed once each.
+     */
+    std::vector<GemmShape> gemmShapes() const;
+
     // --- Utility Functions ---
     
     const Matrix& getActivationAt(int layer) const;
 
+    /**
+     * @brief Whether the weights feeding this layer use the CSR kernel.
+     * Layers are numbered as in LayerPruneReport::layer.
+     */
+    bool usesSparse(int layer) const;
+
     /**
      * @brief Prints the dimensions of all weights and biases.
      * Useful for debugging.
@@ -0,0 +1,214 @@
+#include "onlineLearner.hpp"
+#include <stdexcept>
+#include <limits>
+
+// Raises an atomic maximum; a plain store could lose a concurrent larger value
+static void storeMax(std::atomic<long long>& target, long long value) {
+    long long seen = target.load(std::memory_order_relaxed);
+    while (value > seen && !target.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+// Checked before anything is allocated, so bad arguments leak nothing
+static int checkedReaderCount(int publish_every, int max_readers) {
+    if (publish_every <= 0 || max_readers <= 0) {
+        throw std::invalid_argument("publish_every and max_readers must be positive.");
+    }
+    return max_readers;
+}
+
+// --- Constructor / Destructor ---
+
+OnlineLearner::OnlineLearner(const NeuralNetwork& initial, int publish_every, int max_readers)
+    : current(nullptr), global_epoch(1), slots(new ReaderSlot[checkedReaderCount(publish_every, max_readers)]),
+      max_readers(max_readers), trainer_network(initial), publish_every(publish_every), since_publish(0),
+      stopping(false), training(false), steps(0), publishes(0), publish_ns_total(0), publish_ns_max(0),
+      reads(0), staleness_total(0), staleness_max(0), retired_count(0) {
+    // Readers must not be the ones to read the GEMM tuning cache file
+    GemmTuner::instance().load();
+
+    // Owned here until the trainer is running, in case starting it throws
+    std::unique_ptr<Snapshot> first(new Snapshot{initial.inferenceCopy(), 0});
+    current.store(first.get());
+    trainer = std::thread(&OnlineLearner::trainerLoop, this);
+    first.release();
+}
+
+OnlineLearner::~OnlineLearner() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mtx);
+        stopping = true;
+    }
+    work_cv.notify_one();
+    trainer.join();
+
+    // No readers are left, so everything can go
+    for (const Retired& r : retired) {
+        delete r.snapshot;
+    }
+    delete current.load();
+}
+
+// --- Trainer Side ---
+
+void OnlineLearner::submit(const Matrix& input, const Matrix& target) {
+    {
+        std::lock_guard<std::mutex> lock(queue_mtx);
+        queue.emplace_back(input, target);
+    }
+    work_cv.notify_one();
+}
+
+void OnlineLearner::flush() {
+    std::unique_lock<std::mutex> lock(queue_mtx);
+    idle_cv.wait(lock, [this] { return queue.empty() && !training; });
+}
+
+void OnlineLearner::trainerLoop() {
+    std::unique_lock<std::mutex> lock(queue_mtx);
+    while (true) {
+        work_cv.wait(lock, [this] { return !queue.empty() || stopping; });
+        if (queue.empty()) {
+            break; // stopping, and nothing left to train
+        }
+        std::deque<std::pair<Matrix, Matrix>> batch;
+        batch.swap(queue);
+        training = true;
+        lock.unlock();
+
+        for (const std::pair<Matrix, Matrix>& sample : batch) {
+            trainer_network.feedForward(sample.first);
+            trainer_network.update(sample.second);
+            steps.fetch_add(1, std::memory_order_relaxed);
+            if (++since_publish >= publish_every) {
+                publish();
+            }
+        }
+
+        lock.lock();
+        if (queue.empty() && since_publish > 0) {
+            // Caught up: don't leave readers on an old version while we wait
+            lock.unlock();
+            publish();
+            lock.lock();
+        }
+        training = false;
+        idle_cv.notify_all();
+    }
+}
+
+void OnlineLearner::publish() {
+    auto start = std::chrono::steady_clock::now();
+
+    // Readers only predict, so the training scratch stays behind
+    Snapshot* fresh = new Snapshot{trainer_network.inferenceCopy(), steps.load(std::memory_order_relaxed)};
+    Snapshot* old = current.exchange(fresh);
+    // Readers that announce an epoch after this increment can only see fresh
+    std::uint64_t epoch = global_epoch.fetch_add(1);
+
+    long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    publishes.fetch_add(1, std::memory_order_relaxed);
+    publish_ns_total.fetch_add(ns, std::memory_order_relaxed);
+    storeMax(publish_ns_max, ns);
+    since_publish = 0;
+
+    retired.push_back({old, epoch});
+    reclaim();
+}
+
+void OnlineLearner::reclaim() {
+    // The oldest epoch any reader is still inside
+    std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+    for (int i = 0; i < max_readers; ++i) {
+        if (slots[i].claimed.load()) {
+            std::uint64_t epoch = slots[i].epoch.load();
+            if (epoch != 0 && epoch < oldest) {
+                oldest = epoch;
+            }
+        }
+    }
+
+    // A snapshot retired at epoch e can only be held by readers that announced e or earlier
+    std::vector<Retired> still_used;
+    for (const Retired& r : retired) {
+        if (r.epoch < oldest) {
+            delete r.snapshot;
+        } else {
+            still_used.push_back(r);
+        }
+    }
+    retired.swap(still_used);
+    retired_count.store(retired.size(), std::memory_order_relaxed);
+}
+
+// --- Reader Side ---
+
+OnlineLearner::Reader OnlineLearner::reader() {
+    for (int i = 0; i < max_readers; ++i) {
+        bool expected = false;
+        if (slots[i].claimed.compare_exchange_strong(expected, true)) {
+            return Reader(this, i);
+        }
+    }
+    throw std::runtime_error("Too many OnlineLearner readers.");
+}
+
+OnlineLearner::Reader::Reader(OnlineLearner* learner, int slot) : learner(learner), slot(slot) {
+}
+
+OnlineLearner::Reader::Reader(Reader&& other) noexcept : learner(other.learner), slot(other.slot) {
+    other.learner = nullptr;
+}
+
+OnlineLearner::Reader::~Reader() {
+    if (learner) {
+        learner->slots[slot].claimed.store(false);
+    }
+}
+
+Matrix OnlineLearner::Reader::predict(const Matrix& input) {
+    ReaderSlot& mine = learner->slots[slot];
+
+    // Announce the epoch before loading the pointer, so the trainer keeps
+    // whatever snapshot we are about to see alive until we clear the slot
+    mine.epoch.store(learner->global_epoch.load());
+    Snapshot* snapshot = learner->current.load();
+
+    Matrix output;
+    try {
+        output = snapshot->network.predict(input);
+    } catch (...) {
+        mine.epoch.store(0, std::memory_order_release);
+        throw;
+    }
+    long long staleness = learner->steps.load(std::memory_order_relaxed) - snapshot->version;
+    mine.epoch.store(0, std::memory_order_release);
+
+    learner->reads.fetch_add(1, std::memory_order_relaxed);
+    learner->staleness_total.fetch_add(staleness, std::memory_order_relaxed);
+    storeMax(learner->staleness_max, staleness);
+    return output;
+}
+
+long long OnlineLearner::Reader::version() {
+    ReaderSlot& mine = learner->slots[slot];
+    mine.epoch.store(learner->global_epoch.load());
+    long long version = learner->current.load()->version;
+    mine.epoch.store(0, std::memory_order_release);
+    return version;
+}
+
+// --- Metrics ---
+
+OnlineMetrics OnlineLearner::metrics() const {
+    OnlineMetrics m;
+    m.steps = steps.load();
+    m.publishes = publishes.load();
+    m.avg_publish_us = m.publishes > 0 ? publish_ns_total.load() / 1000.0 / m.publishes : 0.0;
+    m.max_publish_us = publish_ns_max.load() / 1000.0;
+    m.reads = reads.load();
+    m.avg_staleness_steps = m.reads > 0 ? static_cast<double>(staleness_total.load()) / m.reads : 0.0;
+    m.max_staleness_steps = staleness_max.load();
+    m.retired = retired_count.load();
+    return m;
+}
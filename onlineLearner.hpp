@@ -0,0 +1,165 @@
+#ifndef ONLINELEARNER_H
+#define ONLINELEARNER_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include "matrix.hpp"
+#include "neuralNetwork.hpp"
+#include "gemmTuner.hpp"
+
+/**
+ * @brief Counters reported by OnlineLearner::metrics().
+ */
+struct OnlineMetrics {
+    long long steps;             // update() calls applied by the trainer
+    long long publishes;         // versions made visible to readers
+    double avg_publish_us;       // copy + pointer swap, per publish
+    double max_publish_us;
+    long long reads;             // predictions served
+    double avg_staleness_steps;  // steps trained but not yet visible, per read
+    long long max_staleness_steps;
+    long long retired;           // old versions waiting for readers to move on
+};
+
+/**
+ * @brief Trains a model from a stream of samples while other threads predict with it.
+ *
+ * One trainer thread owns a private NeuralNetwork and runs feedForward/update
+ * on every submitted sample. Every publish_every steps, and whenever it runs
+ * out of queued samples, it copies the network's weights (see
+ * NeuralNetwork::inferenceCopy) into a new immutable snapshot and swaps it
+ * in with one atomic pointer exchange (read-copy-update).
+ *
+ * Readers never take a lock. They announce the current epoch in their own
+ * slot, load the pointer, predict, and clear the slot. A replaced snapshot is
+ * freed only once every reader slot is either idle or shows a newer epoch,
+ * so no reader ever sees a half-written or freed model.
+ */
+class OnlineLearner {
+private:
+    struct Snapshot {
+        NeuralNetwork network;
+        long long version; // trainer steps included in this snapshot
+    };
+
+    // One per registered reader, on its own cache line so readers don't contend.
+    // epoch is 0 while the reader is outside predict().
+    struct alignas(64) ReaderSlot {
+        std::atomic<bool> claimed{false};
+        std::atomic<std::uint64_t> epoch{0};
+    };
+
+    struct Retired {
+        Snapshot* snapshot;
+        std::uint64_t epoch;
+    };
+
+    // --- Published State (shared with readers) ---
+    std::atomic<Snapshot*> current;
+    std::atomic<std::uint64_t> global_epoch;
+    std::unique_ptr<ReaderSlot[]> slots;
+    int max_readers;
+
+    // --- Trainer State (trainer thread only) ---
+    NeuralNetwork trainer_network;
+    std::vector<Retired> retired;
+    int publish_every;
+    int since_publish;
+
+    // --- Sample Queue ---
+    std::deque<std::pair<Matrix, Matrix>> queue;
+    bool stopping;
+    bool training; // trainer holds samples taken from the queue
+    std::mutex queue_mtx;
+    std::condition_variable work_cv;
+    std::condition_variable idle_cv;
+    std::thread trainer;
+
+    // --- Metrics ---
+    std::atomic<long long> steps;
+    std::atomic<long long> publishes;
+    std::atomic<long long> publish_ns_total;
+    std::atomic<long long> publish_ns_max;
+    std::atomic<long long> reads;
+    std::atomic<long long> staleness_total;
+    std::atomic<long long> staleness_max;
+    std::atomic<long long> retired_count;
+
+    void trainerLoop();
+    void publish();
+    void reclaim();
+
+public:
+    /**
+     * @brief A reader thread's handle. Each thread that predicts needs its own;
+     * a handle must not be shared between threads or outlive its learner.
+     */
+    class Reader {
+    private:
+        OnlineLearner* learner;
+        int slot;
+
+    public:
+        Reader(OnlineLearner* learner, int slot);
+        ~Reader();
+        Reader(Reader&& other) noexcept;
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+        Reader& operator=(Reader&&) = delete;
+
+        /**
+         * @brief Runs the newest published model on input. Takes no locks
+         * and never waits for the trainer.
+         */
+        Matrix predict(const Matrix& input);
+
+        /**
+         * @brief Trainer steps included in the newest published model.
+         */
+        long long version();
+    };
+
+    /**
+     * @brief Publishes initial as version 0 and starts the trainer thread.
+     * Also loads the GEMM tuning cache, so readers never read it themselves.
+     * @param initial The model to start from; the learner trains its own copy.
+     * @param publish_every Steps between publishes while samples keep arriving.
+     * @param max_readers How many Reader handles may exist at once.
+     */
+    OnlineLearner(const NeuralNetwork& initial, int publish_every = 1, int max_readers = 64);
+
+    /**
+     * @brief Trains any queued samples, then stops the trainer. All Reader
+     * handles must be destroyed first.
+     */
+    ~OnlineLearner();
+
+    OnlineLearner(const OnlineLearner&) = delete;
+    OnlineLearner& operator=(const OnlineLearner&) = delete;
+
+    /**
+     * @brief Registers a reader. Throws std::runtime_error if max_readers are in use.
+     */
+    Reader reader();
+
+    /**
+     * @brief Queues one labelled sample for the trainer.
+     */
+    void submit(const Matrix& input, const Matrix& target);
+
+    /**
+     * @brief Blocks until every submitted sample is trained and published.
+     */
+    void flush();
+
+    OnlineMetrics metrics() const;
+};
+
+#endif // ONLINELEARNER_H
@@ -0,0 +1,47 @@
+#include "philox.hpp"
+
+// Constants from Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3"
+static const std::uint32_t PHILOX_M0 = 0xD2511F53;
+static const std::uint32_t PHILOX_M1 = 0xCD9E8D57;
+static const std::uint32_t PHILOX_W0 = 0x9E3779B9;
+static const std::uint32_t PHILOX_W1 = 0xBB67AE85;
+static const int PHILOX_ROUNDS = 10;
+
+Philox::Philox(std::uint64_t seed, std::uint64_t stream) {
+    key[0] = static_cast<std::uint32_t>(seed);
+    key[1] = static_cast<std::uint32_t>(seed >> 32);
+    stream_lo = static_cast<std::uint32_t>(stream);
+    stream_hi = static_cast<std::uint32_t>(stream >> 32);
+}
+
+Philox::Block Philox::operator()(std::uint64_t counter) const {
+    // The stream id occupies the upper half of the 128-bit counter so that
+    // different streams (e.g. different layers) never overlap.
+    Block ctr = {static_cast<std::uint32_t>(counter), static_cast<std::uint32_t>(counter >> 32),
+                 stream_lo, stream_hi};
+    std::uint32_t k0 = key[0];
+    std::uint32_t k1 = key[1];
+
+    for (int round = 0; round < PHILOX_ROUNDS; ++round) {
+        std::uint64_t p0 = static_cast<std::uint64_t>(PHILOX_M0) * ctr[0];
+        std::uint64_t p1 = static_cast<std::uint64_t>(PHILOX_M1) * ctr[2];
+        std::uint32_t hi0 = static_cast<std::uint32_t>(p0 >> 32);
+        std::uint32_t lo0 = static_cast<std::uint32_t>(p0);
+        std::uint32_t hi1 = static_cast<std::uint32_t>(p1 >> 32);
+        std::uint32_t lo1 = static_cast<std::uint32_t>(p1);
+
+        ctr = {hi1 ^ ctr[1] ^ k0, lo1, hi0 ^ ctr[3] ^ k1, lo0};
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    return ctr;
+}
+
+double Philox::uniform(std::uint64_t index) const {
+    // Each block holds two doubles worth of bits (2 x 64 bits).
+    Block block = (*this)(index / 2);
+    int half = static_cast<int>(index % 2) * 2;
+    std::uint64_t bits = (static_cast<std::uint64_t>(block[half]) << 32) | block[half + 1];
+    // Keep the top 53 bits so every result is exactly representable
+    return static_cast<double>(bits >> 11) * (1.0 / 9007199254740992.0);
+}
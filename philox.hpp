@@ -0,0 +1,32 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <array>
+#include <cstdint>
+
+/**
+ * @brief Counter-based Philox4x32-10 random number generator.
+ *
+ * Unlike std::mt19937 there is no sequential state: the n-th value of a
+ * (seed, stream) pair is computed directly from n. This lets several threads
+ * fill disjoint parts of a matrix and still produce exactly the same numbers
+ * as a single thread would.
+ */
+class Philox
+{
+    public:
+        using Block = std::array<std::uint32_t, 4>;
+
+        Philox(std::uint64_t seed, std::uint64_t stream);
+
+        Block operator()(std::uint64_t counter) const; //4 random words for one counter value
+
+        double uniform(std::uint64_t index) const; //index-th value of the stream, in [0, 1)
+
+    private:
+        std::uint32_t key[2];
+        std::uint32_t stream_lo;
+        std::uint32_t stream_hi;
+};
+
+#endif // PHILOX_H
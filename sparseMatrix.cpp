@@ -0,0 +1,83 @@
+#include <stdexcept>
+#include "sparseMatrix.hpp"
+
+SparseMatrix::SparseMatrix() : row(0), col(0) {
+    // Empty 0x0 matrix, with the single row_ptr entry every CSR matrix has
+    row_ptr.push_back(0);
+}
+
+int SparseMatrix::getRows() const {
+    return row;
+}
+
+int SparseMatrix::getCols() const {
+    return col;
+}
+
+int SparseMatrix::nonZeros() const {
+    return values.size();
+}
+
+double SparseMatrix::sparsity() const {
+    long long total = static_cast<long long>(row) * col;
+    if (total == 0) {
+        return 0.0;
+    }
+    return 1.0 - static_cast<double>(values.size()) / total;
+}
+
+SparseMatrix SparseMatrix::fromDense(const Matrix& m) {
+    SparseMatrix result;
+    result.row = m.getRows();
+    result.col = m.getCols();
+    result.row_ptr.reserve(result.row + 1);
+
+    for (int i = 0; i < m.getRows(); ++i) {
+        for (int j = 0; j < m.getCols(); ++j) {
+            double val = m(i, j);
+            if (val != 0.0) {
+                result.col_idx.push_back(j);
+                result.values.push_back(val);
+            }
+        }
+        result.row_ptr.push_back(result.values.size());
+    }
+    return result;
+}
+
+Matrix SparseMatrix::toDense() const {
+    Matrix result(row, col);
+    for (int i = 0; i < row; ++i) {
+        for (int n = row_ptr[i]; n < row_ptr[i + 1]; ++n) {
+            result(i, col_idx[n]) = values[n];
+        }
+    }
+    return result;
+}
+
+Matrix SparseMatrix::multiply(const SparseMatrix& a, const Matrix& b) {
+    if (a.col != b.getRows()) {
+        throw std::invalid_argument("Matrix inner dimensions must match for multiplication.");
+    }
+    // The kernel streams whole rows of b, so make sure they are contiguous
+    Matrix converted;
+    const Matrix* rows_b = &b;
+    if (b.getLayout() != Matrix::Layout::RowMajor) {
+        converted = Matrix::withLayout(b, Matrix::Layout::RowMajor);
+        rows_b = &converted;
+    }
+
+    Matrix result(a.row, b.getCols());
+    const int width = b.getCols();
+    for (int i = 0; i < a.row; ++i) {
+        double* out = result.line(i);
+        for (int n = a.row_ptr[i]; n < a.row_ptr[i + 1]; ++n) {
+            const double val = a.values[n];
+            const double* b_row = rows_b->line(a.col_idx[n]);
+            for (int j = 0; j < width; ++j) {
+                out[j] += val * b_row[j];
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,37 @@
+#ifndef SPARSEMATRIX_H
+#define SPARSEMATRIX_H
+
+#include <vector>
+#include "matrix.hpp"
+
+/**
+ * @brief A matrix in compressed sparse row (CSR) form.
+ *
+ * Only the nonzero entries are stored: row i owns values[row_ptr[i]] up to
+ * values[row_ptr[i+1]], and col_idx gives each value's column. Used for
+ * inference through pruned weight matrices.
+ */
+class SparseMatrix
+{
+    private:
+        int row;
+        int col;
+        std::vector<int> row_ptr;
+        std::vector<int> col_idx;
+        std::vector<double> values;
+
+    public:
+        SparseMatrix();
+
+        int getRows() const;
+        int getCols() const;
+        int nonZeros() const;
+        double sparsity() const; //fraction of entries that are zero, 0.0 to 1.0
+
+        static SparseMatrix fromDense(const Matrix& m); //keeps every entry that isn't exactly 0.0
+        Matrix toDense() const;
+
+        static Matrix multiply(const SparseMatrix& a, const Matrix& b); //SpMV when b is a column vector, SpMM otherwise
+    };
+
+#endif // SPARSEMATRIX_H
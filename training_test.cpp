@@ -0,0 +1,661 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <algorithm>
+
+#include "matrix.hpp"
+#include "neuralNetwork.hpp"
+#include "dataParallel.hpp"
+#include "checkpoint.hpp"
+#include "onlineLearner.hpp"
+#include "gemmTuner.hpp"
+#include "sparseMatrix.hpp"
+#include "philox.hpp"
+
+/**
+ * @file training_test.cpp
+ * @brief Checks for the training paths main.cpp doesn't exercise.
+ *
+ * Build from the repository root with:
+ *   g++ -std=c++17 -O2 training_test.cpp matrix.cpp neuralNetwork.cpp philox.cpp
+ *       conv2d.cpp sparseMatrix.cpp gemmTuner.cpp dataParallel.cpp checkpoint.cpp onlineLearner.cpp
+ *       -o training_test -pthread
+ *
+ * Adding -fsanitize=thread (or address) also checks the online learner's
+ * snapshot reclamation for races and use-after-free.
+ *
+ * Exits with 1 if any check fails.
+ */
+
+static int failures = 0;
+
+static void check(bool ok, const std::string& what) {
+    if (ok) {
+        std::cout << "   ...ok: " << what << std::endl;
+    } else {
+        std::cout << "   *** ERROR: " << what << std::endl;
+        ++failures;
+    }
+}
+
+// Every element in row-major order, whatever the storage layout
+static std::vector<double> elements(const Matrix& m) {
+    std::vector<double> result;
+    for (int r = 0; r < m.getRows(); ++r) {
+        for (int c = 0; c < m.getCols(); ++c) {
+            result.push_back(m(r, c));
+        }
+    }
+    return result;
+}
+
+static double squaredErrorLoss(NeuralNetwork& nn, const Matrix& input, const Matrix& target) {
+    Matrix error = nn.feedForward(input) - target;
+    return 0.5 * Matrix::multiplyElementWise(error, error).sum();
+}
+
+// --- 1. Conv Backward Pass ---
+
+/**
+ * @brief Compares backward() against central differences of the loss for
+ * every parameter of a conv -> pool -> conv -> dense network.
+ *
+ * With a learning rate of 1.0 the gradient buffers hold the plain gradient.
+ * Parameters are nudged through the same buffers: unpack a one-hot step,
+ * then applyGradients(1.0) subtracts it.
+ */
+static void testConvGradients() {
+    std::cout << "1. Checking conv/pool gradients against finite differences..." << std::endl;
+
+    NeuralNetwork nn(1.0, 3);
+    nn.addInputLayer(2, 7, 7);
+    nn.addConv2D(3, 3, 1, 1, "sigmoid");
+    nn.addMaxPool2D(2, 2);
+    nn.addConv2D(4, 2, 1, 0, "reLu");
+    nn.addLayer(5, "sigmoid");
+
+    Matrix input(98, 1);
+    input.randomize(-1.0, 1.0, 5, 0);
+    Matrix target(5, 1);
+    target.randomize(0.0, 1.0, 5, 1);
+
+    nn.zeroGradients();
+    nn.feedForward(input);
+    nn.backward(target);
+    std::vector<double> analytic;
+    nn.packGradients(analytic);
+    nn.zeroGradients();
+
+    const double h = 1e-6;
+    double worst = 0.0;
+    for (int p = 0; p < analytic.size(); ++p) {
+        std::vector<double> step(analytic.size(), 0.0);
+
+        NeuralNetwork plus = nn;
+        step[p] = -h; // applyGradients subtracts, so this adds h
+        plus.unpackGradients(step);
+        plus.applyGradients(1.0);
+
+        NeuralNetwork minus = nn;
+        step[p] = h;
+        minus.unpackGradients(step);
+        minus.applyGradients(1.0);
+
+        double numeric = (squaredErrorLoss(plus, input, target) - squaredErrorLoss(minus, input, target)) / (2 * h);
+        double difference = std::fabs(numeric - analytic[p]) / std::max(1.0, std::fabs(numeric));
+        worst = std::max(worst, difference);
+    }
+    std::cout << "   " << analytic.size() << " parameters, largest difference " << worst << std::endl;
+    check(worst < 1e-6, "backward() matches the numerical gradient");
+}
+
+// --- 2. Data-Parallel All-Reduce ---
+
+// The 4-bit decoder from main.cpp: input i in binary, one-hot target i
+static void decoderData(std::vector<Matrix>& inputs, std::vector<Matrix>& targets) {
+    for (int i = 0; i < 16; ++i) {
+        std::vector<double> bits(4);
+        for (int b = 0; b < 4; ++b) {
+            bits[b] = (i >> (3 - b)) & 1;
+        }
+        std::vector<double> one_hot(16, 0.0);
+        one_hot[i] = 1.0;
+        inputs.push_back(Matrix::fromVector(bits));
+        targets.push_back(Matrix::fromVector(one_hot));
+    }
+}
+
+/**
+ * @brief Runs 3 ranks over one transport. Each rank checks a known sum,
+ * then trains its replica and compares it with rank 0's. Rank 0's output is
+ * broadcast by all-reducing it against zeros. Any mismatch throws, which
+ * makes launch() report a failure.
+ */
+static void testAllReduce(bool sockets) {
+    std::cout << "2. Checking the " << (sockets ? "socket" : "shared-memory") << " all-reduce with 3 ranks..." << std::endl;
+
+    std::vector<Matrix> inputs, targets;
+    decoderData(inputs, targets);
+
+    DataParallelOptions options;
+    options.processes = 3;
+    options.max_reduce_values = 100; // smaller than the gradients, so reductions are chunked
+    options.force_sockets = sockets;
+
+    int status = DataParallel::launch(options, [&](Communicator& comm) {
+        std::vector<double> values(250, comm.rank() + 1.0);
+        comm.allReduceSum(values.data(), values.size());
+        for (double v : values) {
+            if (v != 6.0) {
+                throw std::runtime_error("All-reduce returned the wrong sum.");
+            }
+        }
+
+        NeuralNetwork nn(0.5);
+        nn.addLayer(4, "input");
+        nn.addLayer(10, "reLu");
+        nn.addLayer(16, "sigmoid");
+        for (int epoch = 0; epoch < 200; ++epoch) {
+            DataParallel::trainEpoch(nn, comm, inputs, targets, 4);
+        }
+
+        std::vector<double> mine;
+        for (const Matrix& input : inputs) {
+            std::vector<double> output = nn.predict(input).toVector();
+            mine.insert(mine.end(), output.begin(), output.end());
+        }
+        std::vector<double> first = comm.rank() == 0 ? mine : std::vector<double>(mine.size(), 0.0);
+        comm.allReduceSum(first.data(), first.size());
+        if (first != mine) {
+            throw std::runtime_error("Replica differs from rank 0 after training.");
+        }
+    });
+    check(status == 0, "sums are exact and all replicas are bit-identical");
+
+    // A failing rank must not leave the others stuck in a reduction
+    options.processes = 2;
+    std::cout << "   (\"Rank N failed\" messages are expected here)" << std::endl;
+    status = DataParallel::launch(options, [](Communicator& comm) {
+        if (comm.rank() == 1) {
+            throw std::runtime_error("deliberate failure");
+        }
+        std::vector<double> values(10, 1.0);
+        comm.allReduceSum(values.data(), values.size());
+    });
+    check(status == 1, "a failed rank is reported instead of hanging");
+}
+
+// --- 3. Checkpoint Round Trip ---
+
+static std::vector<double> allOutputs(const NeuralNetwork& nn, const std::vector<Matrix>& inputs) {
+    std::vector<double> result;
+    for (const Matrix& input : inputs) {
+        std::vector<double> output = nn.predict(input).toVector();
+        result.insert(result.end(), output.begin(), output.end());
+    }
+    return result;
+}
+
+static void trainDecoderEpoch(NeuralNetwork& nn, const std::vector<Matrix>& inputs, const std::vector<Matrix>& targets) {
+    for (int i = 0; i < inputs.size(); ++i) {
+        nn.feedForward(inputs[i]);
+        nn.update(targets[i]);
+    }
+}
+
+/**
+ * @brief Saves a partly trained network, restores it into one built with a
+ * different seed, and checks both predict and keep training identically.
+ */
+static void testCheckpointRoundTrip() {
+    std::cout << "3. Checking a checkpoint capture/resume round trip..." << std::endl;
+
+    const std::string path = "training_test.ckpt";
+    std::remove(path.c_str());
+
+    std::vector<Matrix> inputs, targets;
+    decoderData(inputs, targets);
+
+    NeuralNetwork original(0.5);
+    original.addLayer(4, "input");
+    original.addLayer(10, "reLu");
+    original.addLayer(16, "sigmoid");
+    for (int epoch = 0; epoch < 50; ++epoch) {
+        trainDecoderEpoch(original, inputs, targets);
+    }
+
+    NeuralNetwork restored(0.5, 7);
+    restored.addLayer(4, "input");
+    restored.addLayer(10, "reLu");
+    restored.addLayer(16, "sigmoid");
+    check(Checkpointer::resume(path, restored) == -1, "a missing checkpoint means starting from scratch");
+
+    {
+        Checkpointer checkpointer(path);
+        checkpointer.capture(original, 49);
+        checkpointer.flush();
+        check(checkpointer.writtenCount() == 1, "the capture was written");
+    }
+
+    check(Checkpointer::resume(path, restored) == 49, "resume() returns the saved epoch");
+    check(allOutputs(restored, inputs) == allOutputs(original, inputs), "the restored network predicts identically");
+
+    trainDecoderEpoch(original, inputs, targets);
+    trainDecoderEpoch(restored, inputs, targets);
+    check(allOutputs(restored, inputs) == allOutputs(original, inputs), "and keeps training identically");
+
+    std::remove(path.c_str());
+}
+
+// --- 4. Online Learning ---
+
+/**
+ * @brief Streams the decoder through an OnlineLearner while 4 threads
+ * predict. Readers must only ever see finished versions, in order. Every
+ * replaced snapshot must be freed once its readers are gone, and the final
+ * published model must equal the same samples trained directly.
+ */
+static void testOnlineLearner() {
+    std::cout << "4. Checking online learning with 4 concurrent readers..." << std::endl;
+
+    std::vector<Matrix> inputs, targets;
+    decoderData(inputs, targets);
+
+    NeuralNetwork reference(0.5);
+    reference.addLayer(4, "input");
+    reference.addLayer(10, "reLu");
+    reference.addLayer(16, "sigmoid");
+
+    const int epochs = 100;
+    const int publish_every = 4;
+    const int readers = 4;
+    std::atomic<bool> done(false);
+    std::atomic<int> bad_reads(0);
+    {
+        OnlineLearner learner(reference, publish_every, readers);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < readers; ++t) {
+            threads.emplace_back([&learner, &inputs, &done, &bad_reads, t] {
+                OnlineLearner::Reader reader = learner.reader();
+                long long last_version = 0;
+                for (int n = 0; !done; ++n) {
+                    long long version = reader.version();
+                    Matrix output = reader.predict(inputs[(n + t) % inputs.size()]);
+                    if (version < last_version || !std::isfinite(output.sum())) {
+                        ++bad_reads;
+                    }
+                    last_version = version;
+                }
+            });
+        }
+
+        for (int epoch = 0; epoch < epochs; ++epoch) {
+            for (int i = 0; i < inputs.size(); ++i) {
+                learner.submit(inputs[i], targets[i]);
+            }
+            trainDecoderEpoch(reference, inputs, targets);
+        }
+        learner.flush();
+        done = true;
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        // A descheduled reader can keep recent snapshots alive for a while;
+        // once every reader is idle, the next publish must free all of them
+        learner.submit(inputs[0], targets[0]);
+        reference.feedForward(inputs[0]);
+        reference.update(targets[0]);
+        learner.flush();
+
+        OnlineMetrics metrics = learner.metrics();
+        std::cout << "   " << metrics.publishes << " publishes (avg " << metrics.avg_publish_us << " us), "
+                  << metrics.reads << " reads, average staleness " << metrics.avg_staleness_steps << " steps" << std::endl;
+        check(bad_reads == 0, "readers only saw finished versions, in order");
+        check(metrics.steps == epochs * inputs.size() + 1, "every submitted sample was trained");
+        check(metrics.retired == 0, "no replaced snapshot outlives its readers");
+
+        bool limit_enforced = false;
+        {
+            std::vector<OnlineLearner::Reader> handles;
+            for (int t = 0; t < readers; ++t) {
+                handles.push_back(learner.reader());
+            }
+            try {
+                learner.reader();
+            } catch (const std::runtime_error&) {
+                limit_enforced = true;
+            }
+        }
+        check(limit_enforced, "reader() refuses more than max_readers handles");
+
+        OnlineLearner::Reader reader = learner.reader();
+        check(reader.version() == metrics.steps, "flush() published the last step");
+        check(allOutputs(reference, inputs) == [&] {
+            std::vector<double> result;
+            for (const Matrix& input : inputs) {
+                std::vector<double> output = reader.predict(input).toVector();
+                result.insert(result.end(), output.begin(), output.end());
+            }
+            return result;
+        }(), "the published model equals direct training on the same samples");
+    }
+}
+
+// --- 5. Seeded Initialization ---
+
+/**
+ * @brief Checks Philox against the Random123 known-answer vectors, and that
+ * a seeded fill gives the same bits whether one thread or several write it.
+ */
+static void testPhilox() {
+    std::cout << "5. Checking Philox and seeded matrix fills..." << std::endl;
+
+    // Philox4x32-10 KATs: (counter words, key words) -> output words.
+    // Our counter is (counter lo, counter hi, stream lo, stream hi) and the key is the seed.
+    struct KnownAnswer {
+        std::uint64_t seed, stream, counter;
+        Philox::Block expected;
+    };
+    const KnownAnswer answers[] = {
+        {0, 0, 0, {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}},
+        {~0ULL, ~0ULL, ~0ULL, {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}},
+        {0x299f31d0a4093822ULL, 0x0370734413198a2eULL, 0x85a308d3243f6a88ULL,
+         {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}},
+    };
+    bool all_match = true;
+    for (const KnownAnswer& answer : answers) {
+        all_match = all_match && Philox(answer.seed, answer.stream)(answer.counter) == answer.expected;
+    }
+    check(all_match, "Philox4x32-10 matches the Random123 known answers");
+
+    // Big enough that an automatic fill would also split it between threads
+    Matrix single(300, 300);
+    single.randomize(-1.0, 1.0, 42, 3, 1);
+    bool same_for_all_counts = true;
+    for (int threads : {0, 2, 3, 7}) {
+        Matrix split(300, 300);
+        split.randomize(-1.0, 1.0, 42, 3, threads);
+        same_for_all_counts = same_for_all_counts && elements(split) == elements(single);
+    }
+    check(same_for_all_counts, "a fill gives the same bits for any thread count");
+
+    Matrix col_major(300, 300, Matrix::Layout::ColMajor);
+    col_major.randomize(-1.0, 1.0, 42, 3, 4);
+    check(elements(col_major) == elements(single),
+          "and for either storage layout");
+
+    NeuralNetwork first(0.1, 11), second(0.1, 11), other(0.1, 12);
+    for (NeuralNetwork* nn : {&first, &second, &other}) {
+        nn->addLayer(4, "input");
+        nn->addLayer(10, "reLu");
+        nn->addLayer(16, "sigmoid");
+    }
+    Matrix probe = Matrix::fromVector({1.0, 0.0, 1.0, 1.0});
+    check(first.predict(probe).toVector() == second.predict(probe).toVector(), "the same seed builds the same network");
+    check(first.predict(probe).toVector() != other.predict(probe).toVector(), "a different seed builds a different one");
+}
+
+// --- 6. Matrix Storage ---
+
+/**
+ * @brief Checks padding of short and long lines, and that every operation
+ * gives the same elements whether its operands are row- or column-major,
+ * including mixed pairs.
+ */
+static void testMatrixLayouts() {
+    std::cout << "6. Checking matrix padding and row/column-major storage..." << std::endl;
+
+    check(Matrix(1, 5).getLeadingDim() == 5 && Matrix(1000, 2).getLeadingDim() == 2 && Matrix(7, 1).getLeadingDim() == 1,
+          "lines shorter than a cache line are not padded");
+    check(Matrix(3, 10).getLeadingDim() == 16 && Matrix(2, 512).getLeadingDim() == 520,
+          "longer lines are padded to whole cache lines, avoiding 4 KiB strides");
+
+    const Matrix::Layout layouts[] = {Matrix::Layout::RowMajor, Matrix::Layout::ColMajor};
+    auto filled = [](int rows, int cols, Matrix::Layout layout, std::uint64_t stream) {
+        Matrix m(rows, cols, layout);
+        m.randomize(-1.0, 1.0, 9, stream);
+        return m;
+    };
+
+    // Reference results, all row-major
+    Matrix a = filled(13, 9, Matrix::Layout::RowMajor, 0);
+    Matrix b = filled(13, 9, Matrix::Layout::RowMajor, 1);
+    Matrix c = filled(9, 11, Matrix::Layout::RowMajor, 2);
+    Matrix v = filled(9, 1, Matrix::Layout::RowMajor, 3);
+    Matrix sum = a + b;
+    Matrix difference = a - b;
+    Matrix product = Matrix::multiplyElementWise(a, b);
+    Matrix matrix_product = Matrix::multiply(a, c, GemmConfig());
+    Matrix vector_product = Matrix::multiply(a, v, GemmConfig());
+    Matrix reshaped = Matrix::reshape(a, 9, 13);
+    Matrix activated = Matrix::sigmoid_nonDestructive(a);
+
+    bool all_same = true;
+    for (Matrix::Layout la : layouts) {
+        Matrix a2 = filled(13, 9, la, 0);
+        all_same = all_same && elements(Matrix::withLayout(a2, Matrix::Layout::RowMajor)) == elements(a)
+                            && elements(Matrix::transpose(Matrix::transpose(a2))) == elements(a)
+                            && elements(Matrix::reshape(a2, 9, 13)) == elements(reshaped)
+                            && elements(Matrix::sigmoid_nonDestructive(a2)) == elements(activated)
+                            && a2.sum() == a.sum();
+        for (Matrix::Layout lb : layouts) {
+            Matrix b2 = filled(13, 9, lb, 1);
+            Matrix c2 = filled(9, 11, lb, 2);
+            Matrix v2 = filled(9, 1, lb, 3);
+            all_same = all_same && elements(a2 + b2) == elements(sum)
+                                && elements(a2 - b2) == elements(difference)
+                                && elements(Matrix::multiplyElementWise(a2, b2)) == elements(product)
+                                && elements(Matrix::multiply(a2, c2, GemmConfig())) == elements(matrix_product)
+                                && elements(Matrix::multiply(a2, v2, GemmConfig())) == elements(vector_product);
+            Matrix added = a2;
+            added.addInPlace(b2);
+            Matrix subtracted = a2;
+            subtracted.subtractInPlace(b2);
+            all_same = all_same && elements(added) == elements(sum) && elements(subtracted) == elements(difference);
+        }
+    }
+    check(all_same, "every operation gives the same elements in either layout");
+}
+
+// --- 7. Pruning ---
+
+// A single linear layer's weights, read back through predict(): with no
+// activation and zero biases, the output for the j-th unit vector is column j
+static Matrix probeWeights(const NeuralNetwork& nn, int inputs, int outputs) {
+    Matrix w(outputs, inputs);
+    for (int j = 0; j < inputs; ++j) {
+        Matrix unit(inputs, 1);
+        unit.fill(0.0);
+        unit(j, 0) = 1.0;
+        Matrix column = nn.predict(unit);
+        for (int r = 0; r < outputs; ++r) {
+            w(r, j) = column(r, 0);
+        }
+    }
+    return w;
+}
+
+/**
+ * @brief Checks that pruning leaves at most k weights per row, that the CSR
+ * kernel gives the same products as the pruned dense weights, that layers
+ * below min_sparsity stay dense, and that training drops the CSR copies.
+ */
+static void testPruning() {
+    std::cout << "7. Checking pruning and the CSR kernel..." << std::endl;
+
+    const int inputs = 512;
+    const int outputs = 256;
+    const int top_k = 8;
+    const double threshold = 0.02;
+    auto linearNetwork = [&]() {
+        NeuralNetwork nn(0.1, 31);
+        nn.addLayer(inputs, "input");
+        nn.addLayer(outputs, "none");
+        return nn;
+    };
+    NeuralNetwork nn = linearNetwork();
+
+    std::vector<LayerPruneReport> report = nn.prune(threshold, top_k, 0.5, {}, {});
+    check(report.size() == 1 && report[0].layer == 1 && report[0].non_zeros <= top_k * outputs,
+          "one report for the dense layer, with at most k weights per row in total");
+    check(report[0].uses_sparse && nn.usesSparse(1), "a layer at 98% sparsity switches to the CSR kernel");
+
+    // Through predict(), so this reads what the CSR kernel actually multiplies by
+    Matrix pruned = probeWeights(nn, inputs, outputs);
+    bool rows_ok = true;
+    int non_zeros = 0;
+    for (int r = 0; r < outputs; ++r) {
+        int row_non_zeros = 0;
+        for (int c = 0; c < inputs; ++c) {
+            if (pruned(r, c) != 0.0) {
+                ++row_non_zeros;
+                rows_ok = rows_ok && std::abs(pruned(r, c)) >= threshold;
+            }
+        }
+        rows_ok = rows_ok && row_non_zeros <= top_k;
+        non_zeros += row_non_zeros;
+    }
+    check(rows_ok, "every row keeps at most k weights, none below the threshold");
+    check(non_zeros == report[0].non_zeros, "the report counts the weights that are left");
+
+    Matrix batch(inputs, 5);
+    batch.randomize(-1.0, 1.0, 31, 1);
+    SparseMatrix sparse = SparseMatrix::fromDense(pruned);
+    check(elements(SparseMatrix::multiply(sparse, batch)) == elements(pruned * batch)
+              && elements(sparse.toDense()) == elements(pruned),
+          "SparseMatrix::multiply matches the dense product of the pruned weights");
+
+    // Zero gradients leave the weights as they are, but put the layer back on the dense kernel
+    NeuralNetwork dense = nn;
+    dense.zeroGradients();
+    dense.applyGradients(1.0);
+    Matrix x(inputs, 1);
+    x.randomize(-1.0, 1.0, 31, 2);
+    check(!dense.usesSparse(1) && elements(dense.predict(x)) == elements(nn.predict(x)),
+          "the CSR kernel gives the same outputs as the pruned dense weights");
+
+    Matrix target(outputs, 1);
+    target.fill(0.0);
+    nn.feedForward(x);
+    nn.update(target);
+    check(!nn.usesSparse(1), "update() drops the stale CSR copy");
+
+    NeuralNetwork barely_pruned = linearNetwork();
+    report = barely_pruned.prune(1e-6, 0, 0.5, {}, {});
+    check(report[0].sparsity < 0.5 && !report[0].uses_sparse && !barely_pruned.usesSparse(1),
+          "a layer below min_sparsity stays dense");
+}
+
+// --- 8. GEMM Autotuning ---
+
+/**
+ * @brief Checks that tuned configurations survive a save and reload, that a
+ * cache made for a different core count is ignored, and that every candidate
+ * configuration computes exactly what the default kernel does.
+ */
+static void testGemmTuner() {
+    std::cout << "8. Checking the GEMM tuning cache and candidate kernels..." << std::endl;
+
+    const std::string path = "training_test_gemm.cache";
+    std::remove(path.c_str());
+    GemmTuner& tuner = GemmTuner::instance();
+    tuner.setCachePath(path);
+
+    NeuralNetwork nn(0.1, 5);
+    nn.addLayer(256, "input");
+    nn.addLayer(128, "sigmoid");
+    nn.addLayer(10, "sigmoid");
+    std::vector<GemmShape> shapes = nn.gemmShapes();
+    int tuned = tuner.tuneAll(shapes);
+    check(tuned > 0 && tuner.tuneAll(shapes) == 0, "tuneAll() benchmarks each shape once");
+
+    std::vector<GemmConfig> before;
+    std::vector<GemmShape> tuned_shapes;
+    for (const GemmShape& shape : shapes) {
+        GemmConfig config;
+        if (tuner.lookup(shape, config)) {
+            before.push_back(config);
+            tuned_shapes.push_back(shape);
+        }
+    }
+
+    // Drops the in-memory table, so lookups can only succeed through the file
+    tuner.setCachePath(path);
+    tuner.load();
+    bool reloaded = tuned_shapes.size() == tuned;
+    for (int i = 0; i < tuned_shapes.size(); ++i) {
+        GemmConfig config;
+        reloaded = reloaded && tuner.lookup(tuned_shapes[i], config) && config.block == before[i].block
+                            && config.threads == before[i].threads && config.pack == before[i].pack;
+    }
+    check(reloaded, "a fresh load() reads back every tuned configuration");
+
+    const std::string foreign_path = "training_test_gemm_foreign.cache";
+    {
+        std::ofstream out(foreign_path);
+        out << "# gemm tuning cache v1 threads=" << std::max(1u, std::thread::hardware_concurrency()) + 1 << "\n";
+        out << "128 1 256 0 0 32 1 0\n";
+    }
+    tuner.setCachePath(foreign_path);
+    tuner.load();
+    GemmConfig ignored;
+    check(!tuner.lookup({128, 1, 256, false, false}, ignored), "a cache made for another core count is ignored");
+
+    std::remove(path.c_str());
+    std::remove(foreign_path.c_str());
+    tuner.setCachePath(path);
+
+    // Every kernel accumulates each result in the same order, so the choice never changes the bits
+    const Matrix::Layout layouts[] = {Matrix::Layout::RowMajor, Matrix::Layout::ColMajor};
+    const GemmShape sizes[] = {{70, 150, 200, false, false}, {150, 1, 200, false, false}};
+    bool identical = true;
+    for (const GemmShape& size : sizes) {
+        for (Matrix::Layout la : layouts) {
+            for (Matrix::Layout lb : layouts) {
+                Matrix a(size.m, size.k, la);
+                Matrix b(size.k, size.n, lb);
+                a.randomize(-1.0, 1.0, 5, 0);
+                b.randomize(-1.0, 1.0, 5, 1);
+                std::vector<double> expected = elements(Matrix::multiply(a, b, GemmConfig()));
+
+                GemmShape shape = size;
+                shape.a_col_major = la == Matrix::Layout::ColMajor;
+                shape.b_col_major = lb == Matrix::Layout::ColMajor;
+                for (const GemmConfig& config : GemmTuner::candidates(shape)) {
+                    identical = identical && elements(Matrix::multiply(a, b, config)) == expected;
+                }
+            }
+        }
+    }
+    check(identical, "every candidate configuration gives bit-identical products");
+}
+
+int main() {
+    std::cout << "--- Training Paths Test Program ---" << std::endl << std::endl;
+
+    try {
+        testConvGradients();
+        testAllReduce(false);
+        testAllReduce(true);
+        testCheckpointRoundTrip();
+        testOnlineLearner();
+        testPhilox();
+        testMatrixLayouts();
+        testPruning();
+        testGemmTuner();
+    } catch (const std::exception& e) {
+        std::cerr << "An unexpected error occurred: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << std::endl << "--- Test Complete: " << failures << " failure(s) ---" << std::endl;
+    return failures == 0 ? 0 : 1;
+}